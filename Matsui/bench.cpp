@@ -0,0 +1,230 @@
+// Benchmarks
+// Micro (primitives) and macro (attacks) benchmarks on DES, as JSON
+
+/*
+ * Every benchmark runs its operation in rounds of doubling iteration
+ * counts until one round takes at least the minimum time, and reports
+ * that round: ns per operation, operations per second, ns per block
+ * (for operations on many blocks, else null) and heap allocations per
+ * operation (counted by the global operator new of this program).
+ * The key, data and order are fixed, and attacks run on one thread,
+ * so runs on different branches compare line by line.
+ */
+
+// StdLibs
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <functional>
+#include <tuple>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <new>
+
+// CustomLibs
+#include "primitives/s_box.h"
+#include "primitives/placement.h"
+#include "primitives/bitstring.h"
+#include "primitives/feistel.h"
+#include "primitives/des.h"
+#include "primitives/prng.h"
+#include "primitives/key_enum.h"
+#include "primitives/attack.h"
+
+// Heap allocations of the program
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void *memory = std::malloc(size ? size : 1);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+// Not inlined, or GCC pairs free with operator new at the call sites
+__attribute__((noinline)) void operator delete(void *memory) noexcept
+{
+  std::free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void *memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+// Keeps results alive
+static volatile uint64_t sink;
+
+// Result of a benchmark
+struct bench_result
+{
+  std::string name;                 // Benchmark name
+  uint64_t iterations;              // Iterations of the reported round
+  double ns_per_op;                 // Nanoseconds per operation
+  double ops_per_sec;               // Operations per second
+  double ns_per_block;              // Nanoseconds per block (blocks > 0)
+  double allocs_per_op;             // Heap allocations per operation
+  uint64_t blocks;                  // Blocks per operation (0 = not a block operation)
+};
+
+// Run op in doubling rounds until one takes min_seconds
+bench_result measure(const std::string &name, uint64_t blocks, double min_seconds, const std::function<void()> &op)
+{
+  uint64_t iterations = 1;
+  while (true)
+  {
+    uint64_t allocs = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) op();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    allocs = allocations.load() - allocs;
+    if (seconds >= min_seconds || iterations >= (1ULL << 40))
+    {
+      bench_result result;
+      result.name = name;
+      result.iterations = iterations;
+      result.ns_per_op = seconds * 1e9 / iterations;
+      result.ops_per_sec = iterations / seconds;
+      result.ns_per_block = blocks ? result.ns_per_op / blocks : 0;
+      result.allocs_per_op = (double)allocs / iterations;
+      result.blocks = blocks;
+      return result;
+    }
+    iterations *= 2;
+  }
+}
+
+// Main
+int main(int argc, char **argv)
+{
+  // Options
+  std::string filter = (argc > 1) ? argv[1] : "";
+  double min_seconds = (argc > 2) ? std::atof(argv[2]) : 0.25;
+
+  // DES and Matsui's 3-round approximation
+  bitstring key(64);
+  key.set_uint64(0x0123456789abcdefULL);
+  feistel des = des_cipher(key);
+  placement ip = des.get_ip(), fp = des.get_fp();
+  placement post_sbox = des.get_post_sbox(), prev_sbox = des.get_prev_sbox();
+  bitstring input_mask(64), output_mask(64), last_mask(64), round_mask(32);
+  for (int bit : {32+16, 24, 13, 7, 2}) input_mask.set_bit(bit, 1);
+  for (int bit : {16, 32+24, 32+13, 32+7, 32+2}) last_mask.set_bit(bit, 1);
+  output_mask = input_mask;
+  round_mask.set_bit(16, 1);
+
+  // Inputs
+  bitstring block(64), half(32), round_key(48), other(64);
+  block.set_uint64(0x0123456789abcdefULL);
+  other.set_uint64(0xfedcba9876543210ULL);
+  half.set_uint64(0x89abcdefULL);
+  round_key = des.get_round_key(0);
+  uint64_t round_key_word = round_key.get_uint64();
+  std::vector<s_box> sboxes = des.get_sboxes();
+  std::vector<std::vector<int>> sbox_tables;
+  std::vector<int> sbox_table = sboxes[0].get_table();
+  for (int c = 1; c < 64; c++)
+  {
+    // Shifted S1 tables (no live LAT to reuse)
+    std::vector<int> table(64);
+    for (int x = 0; x < 64; x++) table[x] = sbox_table[x ^ c];
+    sbox_tables.push_back(table);
+  }
+  std::vector<uint64_t> blocks(4096);
+  std::vector<uint64_t> batch(4096);
+  uint64_t state = 1;
+  for (uint64_t &word : blocks) word = splitmix64(state);
+  uint64_t word = 0x0123456789abcdefULL;
+  int counter = 0;
+
+  // Benchmarks (name, blocks per operation, operation)
+  std::vector<std::tuple<std::string, uint64_t, std::function<void()>>> benches;
+
+  // Micro: bitstring, placement, s_box
+  benches.emplace_back("bitstring/xor", 0, [&]() { sink = (block ^ other).get_uint64(); });
+  benches.emplace_back("bitstring/get_slice_int", 0, [&]() { sink = block.get_slice_int(counter & 31, (counter & 31) + 6); counter++; });
+  benches.emplace_back("bitstring/place", 0, [&]() { sink = half.place(prev_sbox).get_uint64(); });
+  benches.emplace_back("placement/place_word", 0, [&]() { word = prev_sbox.place_word(word & 0xffffffffULL) ^ word; sink = word; });
+  benches.emplace_back("s_box/eval", 0, [&]() { sink = sboxes[0].eval(counter++ & 63); });
+  benches.emplace_back("s_box/gen_lat", 0, [&]() { s_box fresh(6, 4, sbox_tables[counter++ % 63]); sink = fresh.get_lat_value(16, 15); });
+
+  // Micro: feistel (the generic variants run the bitstring path, tables off)
+  feistel generic = des;
+  generic.set_table_mode(false);
+  benches.emplace_back("feistel/round_function", 0, [&]() { sink = des.round_function(half, round_key).get_uint64(); });
+  benches.emplace_back("feistel/round_function_generic", 0, [&]() { sink = generic.round_function(half, round_key).get_uint64(); });
+  benches.emplace_back("feistel/round_function_word", 0, [&]() { word = des.round_function_word(word & 0xffffffffULL, round_key_word) ^ word; sink = word; });
+  benches.emplace_back("feistel/encrypt", 1, [&]() { sink = des.encrypt(block, 16).get_uint64(); });
+  benches.emplace_back("feistel/encrypt_generic", 1, [&]() { sink = generic.encrypt(block, 16).get_uint64(); });
+  benches.emplace_back("feistel/decrypt_generic", 1, [&]() { sink = generic.decrypt(block, 16).get_uint64(); });
+  benches.emplace_back("feistel/encrypt_word", 1, [&]() { word = des.encrypt_word(word, 16); sink = word; });
+  benches.emplace_back("feistel/encrypt_batch", batch.size(), [&]()
+  {
+    std::copy(blocks.begin(), blocks.end(), batch.begin());
+    des.encrypt_batch(batch.data(), batch.size(), 16);
+    sink = batch[0];
+  });
+
+  // Macro: attacks (one thread, PRF data)
+  uint64_t pairs = 1 << 16;
+  matsui attack_3(des, 3), attack_4(des, 4), attack_5(des, 5);
+  for (matsui *attack : {&attack_3, &attack_4, &attack_5})
+  {
+    attack->set_seed(1);
+    attack->set_threads(1);
+    attack->set_prf_mode(true);
+  }
+  std::vector<bitstring> masks(64, input_mask);
+  benches.emplace_back("attack/attack_1", pairs, [&]() { sink = attack_3.attack_1(pairs, input_mask, output_mask, 1.56/8, ip, fp); });
+  benches.emplace_back("attack/count_1_masks_64", pairs, [&]() { sink = attack_3.count_1_masks(0, pairs, masks, masks, ip, fp)[0]; });
+  benches.emplace_back("attack/attack_2", pairs, [&]() { sink = attack_4.attack_2(pairs, input_mask, last_mask, round_mask, -1.56/8, ip, fp, post_sbox, prev_sbox).get_uint64(); });
+  benches.emplace_back("attack/attack_2_both", pairs, [&]() { sink = attack_5.attack_2_both(pairs, last_mask, last_mask, round_mask, round_mask, -1.56/8, ip, fp, post_sbox, prev_sbox, 1)[0].score; });
+
+  // Macro: key search (all 2^16 keys, 16 rounds: the pair matches none) and trail search
+  uint64_t plaintexts[2] = {blocks[0], blocks[1]};
+  uint64_t ciphertexts[2] = {des.encrypt_word(plaintexts[0], 16) ^ 1, des.encrypt_word(plaintexts[1], 16)};
+  bitstring known_bits = used_key_bits(des, 16);
+  for (int i = 0, hidden = 0; i < 64 && hidden < 16; i++)
+  {
+    if (known_bits.get_bit(i))
+    {
+      known_bits.set_bit(i, 0);
+      hidden++;
+    }
+  }
+  bitstring partial_key = key & known_bits;
+  benches.emplace_back("key_enum/search_keys", 1 << 16, [&]()
+  {
+    bitstring found(64);
+    uint64_t index = 0;
+    key_search_stats stats;
+    search_keys(des, 16, partial_key, known_bits, plaintexts, ciphertexts, 2, 1, found, index, stats);
+    sink = stats.keys_tested + index;  // No key matches, so index stays 0
+  });
+  benches.emplace_back("trail_search/find_linear_trail_4", 0, [&]() { sink = des.find_linear_trail(4).total_rounds; });
+
+  // Run and report
+  std::cout << "{" << std::endl << "  \"benchmarks\": [" << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+  bool first = true;
+  for (auto &bench : benches)
+  {
+    if (std::get<0>(bench).find(filter) == std::string::npos) continue;
+    bench_result result = measure(std::get<0>(bench), std::get<1>(bench), min_seconds, std::get<2>(bench));
+    if (!first) std::cout << "," << std::endl;
+    first = false;
+    std::cout << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+              << ", \"ns_per_op\": " << result.ns_per_op << ", \"ops_per_sec\": " << result.ops_per_sec
+              << ", \"ns_per_block\": ";
+    if (result.blocks) std::cout << result.ns_per_block;
+    else std::cout << "null";
+    std::cout << ", \"allocs_per_op\": " << result.allocs_per_op << "}";
+  }
+  std::cout << std::endl << "  ]" << std::endl << "}" << std::endl;
+  return 0;
+}
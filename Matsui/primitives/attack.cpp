@@ -6,7 +6,13 @@
 #include <vector>
 #include <cassert>
 #include <algorithm>
+#include <utility>
 #include <cmath>
+#include <cstdlib>
+
+// Custom Library Imports
+#include "walsh.h"
+#include "prng.h"
 
 // Constructors and Destructors
 matsui::matsui(feistel cipher, int num_rounds): cipher(cipher)
@@ -18,6 +24,11 @@ matsui::matsui(feistel cipher, int num_rounds): cipher(cipher)
     // Populate
     this->cipher = cipher;
     this->num_rounds = num_rounds;
+    this->fast_ranking = true;
+    this->seed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+    this->num_threads = 0;
+    this->prf_mode = false;
+    this->data = nullptr;
 }
 
 matsui::~matsui()
@@ -26,172 +37,939 @@ matsui::~matsui()
     // this->cipher = NULL;
 }
 
-// Helper to create a random bitstring
-bitstring create_random_bitstring(int size)
+// Helper to compute the inner product of packed words
+static inline int parity(uint64_t value)
+{
+    return __builtin_parityll(value);
+}
+
+// Helpers to peel IP off a plaintext mask and FP off a ciphertext
+// mask (so they apply to the raw texts)
+static uint64_t input_word(bitstring input_mask, placement &ip)
+{
+    return input_mask.inv_place(ip).get_uint64();
+}
+static uint64_t output_word(bitstring output_mask, placement &fp)
+{
+    return output_mask.place(fp).get_uint64();
+}
+
+// Helper to read the active S-Box inputs (before key mixing) off a
+// right half: the input at shifts[a] of the expanded half goes to
+// bits a*sbox_in .. (a+1)*sbox_in - 1 of the index
+struct sbox_inputs
 {
-    // Check if the size is valid
-    assert(size > 0);
+    placement expansion;            // Right half -> S-Box inputs
+    uint64_t half_mask;
+    uint64_t in_mask;
+    int sbox_in;
+    std::vector<int> shifts;
 
-    // Create a random bitstring
-    bitstring random_bitstring(size);
-    for (int i = 0; i < size; i++)
+    sbox_inputs(placement expansion, int block_size, int sbox_in, std::vector<int> shifts)
+        : expansion(expansion), sbox_in(sbox_in), shifts(shifts)
     {
-        int random_value = rand() % 2;
-        random_bitstring.set_bit(i, random_value);
+        this->half_mask = (block_size/2 == 64) ? ~0ULL : ((1ULL << (block_size/2)) - 1);
+        this->in_mask = (1ULL << sbox_in) - 1;
     }
-    return random_bitstring;
+
+    size_t operator()(uint64_t half) const
+    {
+        uint64_t expanded = this->expansion.place_word(half & this->half_mask);
+        size_t x = 0;
+        for (size_t a = 0; a < this->shifts.size(); a++)
+        {
+            x |= ((expanded >> this->shifts[a]) & this->in_mask) << (a*this->sbox_in);
+        }
+        return x;
+    }
+};
+
+// Helper to build the round key of a guess (bundle a of the guess
+// goes to the a-th active S-Box, other S-Boxes get zero)
+static bitstring guess_round_key(size_t guess, const bitstring &active_sboxes, int sbox_in)
+{
+    int num_sboxes = active_sboxes.get_size();
+    bitstring round_key(sbox_in * num_sboxes);
+    int a = 0;
+    for (int k = 0; k < num_sboxes; k++)
+    {
+        // Check if the s-box is active
+        if (active_sboxes.get_bit(k))
+        {
+            // Extract the ath bundle of sbox_in bits
+            int bundle = (guess >> (a*sbox_in)) & ((1 << sbox_in) - 1);
+            round_key.set_slice(k*sbox_in, (k+1)*sbox_in, bundle);
+            a++;
+        }
+    }
+    return round_key;
 }
 
-// Attack 1
-int matsui::attack_1(int pair_count, bitstring input_mask, bitstring output_mask, float bias, placement ip, placement fp)
+// Read known pairs from a corpus instead of generating them
+void matsui::set_corpus(const corpus *data)
 {
-    // Peel off IP and FP
-    bitstring ip_mask = input_mask.place(ip);
-    bitstring fp_mask = output_mask.inv_place(fp);
+    // Check if the corpus was made with this cipher
+    if (data)
+    {
+        assert(data->is_open());
+        assert(data->get_block_size() == this->cipher.get_block_size());
+        assert(data->get_rounds() == this->num_rounds);
+        assert(data->get_cipher_id() == corpus_cipher_id(this->cipher, this->num_rounds));
+    }
+    this->data = data;
+}
 
-    // Try to find best RHS value
-    int count = 0;
-    for (int i = 0; i < pair_count; i++)
+// Active S-Boxes of a last-round mask
+bitstring matsui::active_sboxes(bitstring round_mask, placement post_sbox)
+{
+    bitstring active(this->cipher.get_num_sboxes());
+    bitstring slayer_mask = round_mask.inv_place(post_sbox);
+    int sbox_out = this->cipher.get_sbox_out();
+    for (int i = 0; i < this->cipher.get_num_sboxes(); i++)
     {
-        // Create random input and output
-        bitstring input = create_random_bitstring(this->cipher.get_block_size());
-        bitstring output = this->cipher.encrypt(input, this->num_rounds);
+        if (slayer_mask.get_slice_int(i*sbox_out, (i+1)*sbox_out) != 0) active.set_bit(i, 1);
+    }
+    return active;
+}
 
-        // Apply masks
-        int ip_dot = input*ip_mask;
-        int fp_dot = output*fp_mask;
+// Shift of every active S-Box input in the expanded right half
+std::vector<int> matsui::input_shifts(bitstring active_sboxes)
+{
+    int sbox_in = this->cipher.get_sbox_in();
+    int num_sboxes = this->cipher.get_num_sboxes();
+    int layer = sbox_in * num_sboxes;
+    std::vector<int> shifts;
+    for (int k = 0; k < num_sboxes; k++)
+    {
+        if (active_sboxes.get_bit(k)) shifts.push_back(layer - (k + 1)*sbox_in);
+    }
+    return shifts;
+}
 
-        // Increment count conditionally
-        if (ip_dot == fp_dot) count ++;
+// Visit the pairs [begin, end) on the workers (generated or read)
+void matsui::collect(uint64_t begin, uint64_t end, const work_pool &workers,
+                     const std::function<void(int, const uint64_t *, const uint64_t *, size_t)> &visit)
+{
+    // Check if the range is valid and the block fits a packed word
+    int block_size = this->cipher.get_block_size();
+    assert(block_size <= 64 && begin <= end);
+    if (begin == end) return;
+
+    // Chunk c holds pairs c*BATCH_SIZE .. (c+1)*BATCH_SIZE - 1, cut to the range
+    uint64_t first = begin / BATCH_SIZE;
+    size_t chunks = (end - 1) / BATCH_SIZE - first + 1;
+    auto bounds = [&](size_t index, uint64_t &lo, uint64_t &hi)
+    {
+        uint64_t chunk = first + index;
+        lo = std::max<uint64_t>(begin, chunk * BATCH_SIZE);
+        hi = std::min<uint64_t>(end, (chunk + 1) * BATCH_SIZE);
+    };
+
+    // Stream the pairs from the corpus (no copies)
+    if (this->data)
+    {
+        assert(end <= this->data->get_count());
+        const uint64_t *plaintexts = this->data->get_plaintexts();
+        const uint64_t *ciphertexts = this->data->get_ciphertexts();
+        workers.run(chunks, [&](int worker, size_t index)
+        {
+            uint64_t lo, hi;
+            bounds(index, lo, hi);
+            visit(worker, plaintexts + lo, ciphertexts + lo, hi - lo);
+        });
+        return;
+    }
+
+    // Buffers of every worker
+    int threads = workers.get_num_threads();
+    std::vector<std::vector<uint64_t>> inputs(threads, std::vector<uint64_t>(BATCH_SIZE));
+    std::vector<std::vector<uint64_t>> outputs(threads, std::vector<uint64_t>(BATCH_SIZE));
+    uint64_t mask = (block_size == 64) ? ~0ULL : ((1ULL << block_size) - 1);
+    workers.run(chunks, [&](int worker, size_t index)
+    {
+        // Plaintexts of the chunk (PRF words, or stream c up to the end of the range)
+        uint64_t lo, hi;
+        bounds(index, lo, hi);
+        uint64_t *input = inputs[worker].data();
+        uint64_t *output = outputs[worker].data();
+        size_t batch = hi - lo;
+        if (this->prf_mode)
+        {
+            for (size_t i = 0; i < batch; i++) input[i] = prf64(this->seed, lo + i) & mask;
+        }
+        else
+        {
+            uint64_t start = (first + index) * BATCH_SIZE;
+            random_blocks(this->seed, first + index, input, hi - start, block_size);
+            input += lo - start;
+        }
+
+        // Ciphertexts
+        std::copy(input, input + batch, output);
+        this->cipher.encrypt_batch(output, batch, this->num_rounds);
+
+        visit(worker, input, output, batch);
+    });
+}
+
+// Table of size counters over the pairs [begin, end): every pair adds
+// sign (1 unless set) to entry index(input, output, sign). Every
+// worker fills its own table, merged at the end
+template <typename Index>
+std::vector<int64_t> matsui::collect_table(uint64_t begin, uint64_t end, size_t size, Index index)
+{
+    work_pool workers(this->num_threads);
+    std::vector<std::vector<int64_t>> local(workers.get_num_threads());
+    this->collect(begin, end, workers, [&](int worker, const uint64_t *inputs, const uint64_t *outputs, size_t batch)
+    {
+        std::vector<int64_t> &table = local[worker];
+        if (table.empty()) table.assign(size, 0);
+        for (size_t i = 0; i < batch; i++)
+        {
+            int64_t sign = 1;
+            size_t x = index(inputs[i], outputs[i], sign);
+            table[x] += sign;
+        }
+    });
+
+    // Merge
+    std::vector<int64_t> counters(size, 0);
+    for (std::vector<int64_t> &table : local)
+    {
+        for (size_t x = 0; x < table.size(); x++) counters[x] += table[x];
+        std::vector<int64_t>().swap(table);
     }
+    return counters;
+}
+
+// Algorithm 1 data pass: pairs in [begin, end) where the masked parities agree
+uint64_t matsui::count_1(uint64_t begin, uint64_t end, bitstring input_mask, bitstring output_mask, placement ip, placement fp)
+{
+    // Peel off IP and FP from the masks (so they apply to the raw texts)
+    uint64_t ip_word = input_word(input_mask, ip);
+    uint64_t fp_word = output_word(output_mask, fp);
 
+    // One count per worker
+    work_pool workers(this->num_threads);
+    std::vector<uint64_t> counts(workers.get_num_threads(), 0);
+    this->collect(begin, end, workers, [&](int worker, const uint64_t *inputs, const uint64_t *outputs, size_t batch)
+    {
+        uint64_t count = 0;
+        for (size_t i = 0; i < batch; i++)
+        {
+            // Apply masks
+            int ip_dot = parity(inputs[i] & ip_word);
+            int fp_dot = parity(outputs[i] & fp_word);
+
+            // Increment count conditionally
+            if (ip_dot == fp_dot) count ++;
+        }
+        counts[worker] += count;
+    });
+    uint64_t count = 0;
+    for (uint64_t c : counts) count += c;
+    return count;
+}
+
+// Algorithm 1 data pass for many approximations at once (one count per mask pair)
+std::vector<uint64_t> matsui::count_1_masks(uint64_t begin, uint64_t end, std::vector<bitstring> input_masks, std::vector<bitstring> output_masks, placement ip, placement fp)
+{
+    // Peel off IP and FP from the masks (so they apply to the raw texts)
+    assert(input_masks.size() == output_masks.size());
+    size_t num_masks = input_masks.size();
+    std::vector<uint64_t> ip_words(num_masks);
+    std::vector<uint64_t> fp_words(num_masks);
+    for (size_t m = 0; m < num_masks; m++)
+    {
+        ip_words[m] = input_word(input_masks[m], ip);
+        fp_words[m] = output_word(output_masks[m], fp);
+    }
+
+    // Parity slices and counts per worker
+    work_pool workers(this->num_threads);
+    int threads = workers.get_num_threads();
+    std::vector<parity_slices> in_slices(threads);
+    std::vector<parity_slices> out_slices(threads);
+    std::vector<std::vector<uint64_t>> local(threads);
+    this->collect(begin, end, workers, [&](int worker, const uint64_t *inputs, const uint64_t *outputs, size_t batch)
+    {
+        if (local[worker].empty()) local[worker].assign(num_masks, 0);
+        in_slices[worker].load(inputs, batch);
+        out_slices[worker].load(outputs, batch);
+        count_agreements(in_slices[worker], ip_words, out_slices[worker], fp_words, local[worker].data());
+    });
+
+    // Merge
+    std::vector<uint64_t> counts(num_masks, 0);
+    for (const std::vector<uint64_t> &table : local)
+    {
+        for (size_t m = 0; m < table.size(); m++) counts[m] += table[m];
+    }
+    return counts;
+}
+
+// Algorithm 1 decision from the count over pair_count pairs
+int matsui::decide_1(uint64_t count, uint64_t pair_count, float bias)
+{
     // Compute expected bias
-    float expected_bias = ((float)count / (float)pair_count) - 0.5;
+    float expected_bias = ((double)count / (double)pair_count) - 0.5;
 
     // If both have same signs, return 0
     if (expected_bias * bias > 0) return 0;
     else return 1;
 }
 
-// Attack 2
-bitstring matsui::attack_2(int pair_count, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox)
+// Attack 1
+int matsui::attack_1(uint64_t pair_count, bitstring input_mask, bitstring output_mask, float bias, placement ip, placement fp)
+{
+    uint64_t count = this->count_1(0, pair_count, input_mask, output_mask, ip, fp);
+    return this->decide_1(count, pair_count, bias);
+}
+
+// Upper normal quantile: z with P(Z > z) = tail (bisection on erfc)
+static double normal_quantile(double tail)
+{
+    assert(tail > 0 && tail < 1);
+    double lo = -40, hi = 40;
+    for (int i = 0; i < 200; i++)
+    {
+        double mid = (lo + hi) / 2;
+        if (0.5 * std::erfc(mid / std::sqrt(2.0)) > tail) lo = mid;
+        else hi = mid;
+    }
+    return (lo + hi) / 2;
+}
+
+// Adaptive Attack 1: double the pairs until the sign of the bias is settled
+int matsui::attack_1_adaptive(uint64_t max_pairs, double success, bitstring input_mask, bitstring output_mask, float bias, placement ip, placement fp, uint64_t &pairs_used)
+{
+    // Assert
+    assert(max_pairs > 0);
+    assert(success > 0 && success < 1);
+
+    // Check i may fail with probability (1 - success) / 2^i, so all
+    // of them together stay within the requested failure rate
+    uint64_t count = 0;
+    uint64_t used = 0;
+    double failure = 1 - success;
+    for (int check = 1; used < max_pairs; check++)
+    {
+        uint64_t next = std::min<uint64_t>(max_pairs, std::max<uint64_t>(ADAPTIVE_START, 2 * used));
+        count += this->count_1(used, next, input_mask, output_mask, ip, fp);
+        used = next;
+
+        // Running bias estimate against its confidence bound (sd 1/(2 sqrt(N)))
+        double estimate = (double)count / (double)used - 0.5;
+        double bound = normal_quantile(std::ldexp(failure, -std::min(check, 1000))) * 0.5 / std::sqrt((double)used);
+        if (std::fabs(estimate) > bound) break;
+    }
+    pairs_used = used;
+    return this->decide_1(count, used, bias);
+}
+
+// Histogram of the chosen plaintext (after IP) and ciphertext (before FP) bits over [begin, end)
+std::vector<int64_t> matsui::histogram(uint64_t begin, uint64_t end, std::vector<int> input_bits, std::vector<int> output_bits, placement ip, placement fp)
+{
+    // Raw text mask of every chosen bit (IP and FP peeled off)
+    int block_size = this->cipher.get_block_size();
+    int k = input_bits.size() + output_bits.size();
+    assert(k > 0 && k < 8 * (int)sizeof(size_t) - 1);
+    std::vector<uint64_t> in_words;
+    std::vector<uint64_t> out_words;
+    for (int bit : input_bits)
+    {
+        bitstring mask(block_size);
+        mask.set_bit(bit, 1);
+        in_words.push_back(input_word(mask, ip));
+    }
+    for (int bit : output_bits)
+    {
+        bitstring mask(block_size);
+        mask.set_bit(bit, 1);
+        out_words.push_back(output_word(mask, fp));
+    }
+
+    // Index of the chosen bits of every pair
+    return this->collect_table(begin, end, (size_t)1 << k, [&](uint64_t input, uint64_t output, int64_t &)
+    {
+        size_t x = 0;
+        for (uint64_t word : in_words) x = (x << 1) | parity(input & word);
+        for (uint64_t word : out_words) x = (x << 1) | parity(output & word);
+        return x;
+    });
+}
+
+// Correlation of every mask on the chosen bits
+std::vector<double> matsui::spectrum(uint64_t begin, uint64_t end, std::vector<int> input_bits, std::vector<int> output_bits, placement ip, placement fp)
+{
+    assert(begin < end);
+    std::vector<int64_t> counts = this->histogram(begin, end, input_bits, output_bits, ip, fp);
+    fwht(counts.data(), counts.size());
+
+    std::vector<double> correlations(counts.size());
+    for (size_t u = 0; u < counts.size(); u++) correlations[u] = (double)counts[u] / (double)(end - begin);
+    return correlations;
+}
+
+// Input and output masks of a spectrum index
+void matsui::spectrum_masks(size_t index, std::vector<int> input_bits, std::vector<int> output_bits, bitstring &input_mask, bitstring &output_mask)
+{
+    int block_size = this->cipher.get_block_size();
+    int k = input_bits.size() + output_bits.size();
+    input_mask = bitstring(block_size);
+    output_mask = bitstring(block_size);
+    for (size_t j = 0; j < input_bits.size(); j++)
+    {
+        if ((index >> (k - 1 - j)) & 1) input_mask.set_bit(input_bits[j], 1);
+    }
+    for (size_t j = 0; j < output_bits.size(); j++)
+    {
+        if ((index >> (output_bits.size() - 1 - j)) & 1) output_mask.set_bit(output_bits[j], 1);
+    }
+}
+
+// Algorithm 2 data pass: distilled counters of the pairs in [begin, end)
+std::vector<int64_t> matsui::distil_2(uint64_t begin, uint64_t end, bitstring input_mask, bitstring output_mask, bitstring round_mask, placement ip, placement fp, placement post_sbox, placement prev_sbox)
 {
     // Assert 
-    assert(pair_count > 0);
     assert(input_mask.get_size() == this->cipher.get_block_size());
     assert(output_mask.get_size() == this->cipher.get_block_size());
 
-    // Identify active s-boxes
-    bitstring active_sboxes(this->cipher.get_num_sboxes());
-    bitstring slayer_mask = round_mask.inv_place(post_sbox);
-    int sbox_out = this->cipher.get_sbox_out();
+    // Bits to guess over
+    bitstring active = this->active_sboxes(round_mask, post_sbox);
     int sbox_in = this->cipher.get_sbox_in();
-    int num_sboxes = this->cipher.get_num_sboxes();
-    for (int i = 0; i < num_sboxes; i++)
+    int guess_bits = active.hamming_weight() * sbox_in;
+    assert(guess_bits < 8 * (int)sizeof(size_t) - 1);
+    size_t guesses = (size_t)1 << guess_bits;
+
+    // Peel off IP and FP from the masks (so they apply to the raw texts)
+    uint64_t ip_word = input_word(input_mask, ip);
+    uint64_t fp_word = output_word(output_mask, fp);
+
+    // Active S-Box inputs of the ciphertext right half (FP peeled off)
+    sbox_inputs last(prev_sbox, this->cipher.get_block_size(), sbox_in, this->input_shifts(active));
+
+    // Distillation: counters[x] is the number of pairs whose active
+    // S-Box inputs are x (before key mixing) and whose masked text
+    // parity is 0, minus those whose parity is 1
+    return this->collect_table(begin, end, guesses, [&](uint64_t input, uint64_t output, int64_t &sign)
     {
-        if (slayer_mask.get_slice_int(i*sbox_out, (i+1)*sbox_out) != 0) active_sboxes.set_bit(i, 1);
-    }
+        sign = (parity(input & ip_word) ^ parity(output & fp_word)) ? -1 : 1;
+        return last(fp.inv_place_word(output));
+    });
+}
 
-    // Bits to guess over
-    int guess_bits = active_sboxes.hamming_weight() * sbox_in;
+// Score of every key guess from distilled counters over the active S-Boxes
+std::vector<int64_t> matsui::score_guesses(std::vector<int64_t> counters, bitstring round_mask, bitstring active_sboxes)
+{
+    return this->score_guesses(std::move(counters), std::vector<bitstring>{round_mask}, std::vector<bitstring>{active_sboxes});
+}
 
-    // Create a vector of ints (buckets for each guess)
-    std::vector<int> buckets((1 << guess_bits), 0);
-    std::vector<bitstring> round_keys((1 << guess_bits), bitstring(sbox_out * num_sboxes));
-    // Iterate over guesses
-    for (int j = 0; j < (1 << guess_bits); j++)
+// Score of every key guess over several rounds (side 0 in the lowest index bits)
+std::vector<int64_t> matsui::score_guesses(std::vector<int64_t> counters, std::vector<bitstring> round_masks, std::vector<bitstring> actives)
+{
+    // Layout of the guesses: the bundles of every side, one after the other
+    assert(round_masks.size() == actives.size());
+    int sbox_in = this->cipher.get_sbox_in();
+    size_t sides = actives.size();
+    std::vector<int> offsets(sides + 1, 0);
+    for (size_t s = 0; s < sides; s++) offsets[s + 1] = offsets[s] + actives[s].hamming_weight() * sbox_in;
+    size_t guesses = (size_t)1 << offsets[sides];
+    uint64_t in_mask = (1ULL << sbox_in) - 1;
+    assert(counters.size() == guesses);
+
+    // Key ranking: the score of guess j is
+    //   sum_x counters[x] * (-1)^f(x ^ j) = 2*(pairs with t == f) - pair_count
+    // where f is the xor of the masked round function parities of the
+    // sides on their S-Box inputs (a zero right half puts the round
+    // key straight into the S-Boxes)
+    bitstring zero_half(this->cipher.get_block_size()/2);
+    std::vector<int> f_zero(sides);
+    int constant = 0;
+    for (size_t s = 0; s < sides; s++)
+    {
+        f_zero[s] = this->cipher.round_function(zero_half, guess_round_key(0, actives[s], sbox_in))*round_masks[s];
+        constant ^= f_zero[s];
+    }
+    std::vector<int64_t> scores;
+    if (this->fast_ranking)
     {
-        // Create round key
-        bitstring round_key = bitstring(sbox_in * num_sboxes);
-        int a = 0;
-        for (int k = 0; k < num_sboxes; k++)
+        // f is a xor of one function per active S-Box (and a constant),
+        // so the xor-convolution with (-1)^f factors into one
+        // convolution per bundle, each done in the Walsh domain of its
+        // own bits. Every intermediate value is a signed sum of
+        // counters, so nothing grows past pair_count * 2^(3*sbox_in).
+        std::vector<int64_t> spectrum(1 << sbox_in);
+        for (size_t s = 0; s < sides; s++)
         {
-            // Check if the s-box is active
-            if (active_sboxes.get_bit(k))
+            for (int a = 0; a < actives[s].hamming_weight(); a++)
             {
-               // Extract the ath bundle of sbox_in bits
-               int bundle = (j >> (a*sbox_in)) & ((1 << sbox_in) - 1);
-               // Set the bits in the round key
-               round_key.set_slice(k*sbox_in, (k+1)*sbox_in, bundle);
+                // Walsh spectrum of (-1)^f on bundle a of side s (without the constant)
+                for (int v = 0; v < (1 << sbox_in); v++)
+                {
+                    bitstring round_key = guess_round_key((size_t)v << (a*sbox_in), actives[s], sbox_in);
+                    int f_v = this->cipher.round_function(zero_half, round_key)*round_masks[s];
+                    spectrum[v] = (f_v ^ f_zero[s]) ? -1 : 1;
+                }
+                fwht(spectrum.data(), spectrum.size());
+
+                // Convolve along the bits of the bundle
+                int lo = offsets[s] + a*sbox_in;
+                fwht_bits(counters.data(), guesses, lo, lo + sbox_in);
+                for (size_t x = 0; x < guesses; x++)
+                {
+                    counters[x] *= spectrum[(x >> lo) & in_mask];
+                }
+                fwht_bits(counters.data(), guesses, lo, lo + sbox_in);
+                for (size_t x = 0; x < guesses; x++) counters[x] /= (1 << sbox_in);
             }
         }
-        round_keys[j] = round_key;
+        if (constant)
+        {
+            for (size_t x = 0; x < guesses; x++) counters[x] = -counters[x];
+        }
+        scores.swap(counters);
     }
+    else
+    {
+        // Parity of the masked round function outputs for every S-Box input
+        std::vector<int> f_parity(guesses, 0);
+        for (size_t s = 0; s < sides; s++)
+        {
+            size_t side_guesses = (size_t)1 << (offsets[s + 1] - offsets[s]);
+            std::vector<int> side_parity(side_guesses);
+            for (size_t y = 0; y < side_guesses; y++)
+            {
+                side_parity[y] = this->cipher.round_function(zero_half, guess_round_key(y, actives[s], sbox_in))*round_masks[s];
+            }
+            for (size_t y = 0; y < guesses; y++) f_parity[y] ^= side_parity[(y >> offsets[s]) & (side_guesses - 1)];
+        }
+
+        // Score every guess over the whole table
+        scores.assign(guesses, 0);
+        for (size_t j = 0; j < guesses; j++)
+        {
+            for (size_t x = 0; x < guesses; x++)
+            {
+                scores[j] += f_parity[x ^ j] ? -counters[x] : counters[x];
+            }
+        }
+    }
+    return scores;
+}
+
+// Partial master key of a guess (key bits of the active S-Boxes in a round)
+bitstring matsui::partial_key(size_t guess, bitstring active_sboxes, int round)
+{
+    int sbox_in = this->cipher.get_sbox_in();
+    int num_sboxes = this->cipher.get_num_sboxes();
+    bitstring reqd_key = guess_round_key(guess, active_sboxes, sbox_in);
+
+    // Get key schedule (of the round)
+    std::vector<int> schedule = this->cipher.get_key_schedule()[round];
 
-    // For each guess
-    for (int i = 0; i < pair_count; i++)
+    // Create a partial key
+    bitstring partial_key = bitstring(this->cipher.get_key_size());
+    for (int i = 0; i < sbox_in*num_sboxes ; i++)
     {
-        // Create random input and output
-        bitstring input = create_random_bitstring(this->cipher.get_block_size());
-        bitstring output = this->cipher.encrypt(input, this->num_rounds);
+        // Set the bits of the active S-Boxes in the partial key
+        if (active_sboxes.get_bit(i / sbox_in)) partial_key.set_bit(schedule[i], reqd_key.get_bit(i));
+    }
+    return partial_key;
+}
 
-        // Peel off IP and FP
-        bitstring mod_input = input.place(ip);
-        bitstring mod_output = output.inv_place(fp);
+// Master key bits fixed by a guess on the active S-Boxes in a round
+bitstring matsui::guessed_key_bits(bitstring active_sboxes, int round)
+{
+    int sbox_in = this->cipher.get_sbox_in();
+    std::vector<int> schedule = this->cipher.get_key_schedule()[round];
+    bitstring known_bits(this->cipher.get_key_size());
+    for (int k = 0; k < this->cipher.get_num_sboxes(); k++)
+    {
+        if (!active_sboxes.get_bit(k)) continue;
+        for (int i = k*sbox_in; i < (k + 1)*sbox_in; i++) known_bits.set_bit(schedule[i], 1);
+    }
+    return known_bits;
+}
+
+// Algorithm 2 key ranking from (merged) distilled counters
+bitstring matsui::rank_2(const std::vector<int64_t> &counters, bitstring round_mask, float bias, placement post_sbox)
+{
+    bitstring active_sboxes = this->active_sboxes(round_mask, post_sbox);
+    std::vector<int64_t> scores = this->score_guesses(counters, round_mask, active_sboxes);
+
+    // Largest absolute score (ties by index)
+    size_t best = 0;
+    for (size_t j = 1; j < scores.size(); j++)
+    {
+        if (std::abs(scores[j]) > std::abs(scores[best])) best = j;
+    }
+    return this->partial_key(best, active_sboxes, this->num_rounds - 1);
+}
 
-        // Right half of ciphertext
-        bitstring right_half = mod_output.get_slice_int(this->cipher.get_block_size()/2, this->cipher.get_block_size());
-        
-        // Iterate over guesses
-        for (int j = 0; j < (1 << guess_bits); j++)
+// Indices of the count largest absolute scores (ties by index), best first
+static std::vector<size_t> top_guesses(const std::vector<int64_t> &scores, size_t count)
+{
+    // Bounded heap with the worst kept guess on top
+    auto better = [&](size_t a, size_t b)
+    {
+        if (std::abs(scores[a]) != std::abs(scores[b])) return std::abs(scores[a]) > std::abs(scores[b]);
+        return a < b;
+    };
+    std::vector<size_t> order;
+    order.reserve(std::min(count, scores.size()));
+    for (size_t j = 0; j < scores.size() && count > 0; j++)
+    {
+        if (order.size() < count)
+        {
+            order.push_back(j);
+            std::push_heap(order.begin(), order.end(), better);
+        }
+        else if (better(j, order.front()))
         {
-            // Create round key
-            bitstring round_key = round_keys[j];
+            std::pop_heap(order.begin(), order.end(), better);
+            order.back() = j;
+            std::push_heap(order.begin(), order.end(), better);
+        }
+    }
+    std::sort_heap(order.begin(), order.end(), better);
+    return order;
+}
 
-            // Apply masks
-            int ip_dot = mod_input*input_mask;
-            int fp_dot = mod_output*output_mask;
-            
-            // Perform round_key function on right half
-            bitstring round_key_out = this->cipher.round_function(right_half, round_key);
-            int rk_dot = round_key_out*round_mask;
-
-            // Conditionally increment buckets
-            if ((ip_dot ^ fp_dot ^ rk_dot) == 0)
+// Algorithm 2 candidates: the top_k guesses by absolute score
+std::vector<key_candidate> matsui::rank_2_candidates(const std::vector<int64_t> &counters, bitstring round_mask, float bias, placement post_sbox, int top_k)
+{
+    bitstring active_sboxes = this->active_sboxes(round_mask, post_sbox);
+    std::vector<int64_t> scores = this->score_guesses(counters, round_mask, active_sboxes);
+
+    // Order the top_k guesses by absolute score (ties by index)
+    assert(top_k > 0);
+    std::vector<size_t> order = top_guesses(scores, top_k);
+
+    // Master key bits fixed by a guess
+    bitstring known_bits = this->guessed_key_bits(active_sboxes, this->num_rounds - 1);
+
+    std::vector<key_candidate> candidates;
+    for (size_t guess : order)
+    {
+        // Check what is RHS, based on whether the score matches the bias (sign-wise)
+        int rhs = (scores[guess] * bias > 0) ? 0 : 1;
+        candidates.push_back(key_candidate{this->partial_key(guess, active_sboxes, this->num_rounds - 1), known_bits, scores[guess], rhs});
+    }
+    return candidates;
+}
+
+// Attack 2
+bitstring matsui::attack_2(uint64_t pair_count, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox)
+{
+    // Assert 
+    assert(pair_count > 0);
+
+    std::vector<int64_t> counters = this->distil_2(0, pair_count, input_mask, output_mask, round_mask, ip, fp, post_sbox, prev_sbox);
+    return this->rank_2(counters, round_mask, bias, post_sbox);
+}
+
+// Attack 2 with the top_k candidates
+std::vector<key_candidate> matsui::attack_2_candidates(uint64_t pair_count, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox, int top_k)
+{
+    // Assert
+    assert(pair_count > 0);
+
+    std::vector<int64_t> counters = this->distil_2(0, pair_count, input_mask, output_mask, round_mask, ip, fp, post_sbox, prev_sbox);
+    return this->rank_2_candidates(counters, round_mask, bias, post_sbox, top_k);
+}
+
+// Two-ended data pass: distilled counters over the first- and last-round S-Box inputs
+std::vector<int64_t> matsui::distil_2_both(uint64_t begin, uint64_t end, bitstring input_mask, bitstring output_mask, bitstring first_mask, bitstring round_mask, placement ip, placement fp, placement post_sbox, placement prev_sbox)
+{
+    // Assert
+    assert(input_mask.get_size() == this->cipher.get_block_size());
+    assert(output_mask.get_size() == this->cipher.get_block_size());
+
+    // Bits to guess over (last round low, first round high)
+    bitstring last_active = this->active_sboxes(round_mask, post_sbox);
+    bitstring first_active = this->active_sboxes(first_mask, post_sbox);
+    int sbox_in = this->cipher.get_sbox_in();
+    int last_bits = last_active.hamming_weight() * sbox_in;
+    int guess_bits = last_bits + first_active.hamming_weight() * sbox_in;
+    assert(guess_bits < 8 * (int)sizeof(size_t) - 1);
+    size_t guesses = (size_t)1 << guess_bits;
+
+    // Peel off IP and FP from the masks (so they apply to the raw texts)
+    uint64_t ip_word = input_word(input_mask, ip);
+    uint64_t fp_word = output_word(output_mask, fp);
+
+    // Active S-Box inputs of the plaintext (after IP) and ciphertext (FP peeled off) right halves
+    int block_size = this->cipher.get_block_size();
+    sbox_inputs first(prev_sbox, block_size, sbox_in, this->input_shifts(first_active));
+    sbox_inputs last(prev_sbox, block_size, sbox_in, this->input_shifts(last_active));
+
+    // Distillation: counters[(x1 << last_bits) | x2] is the number of
+    // pairs whose first-round S-Box inputs (plaintext side) are x1 and
+    // last-round ones (ciphertext side) are x2 with text parity 0,
+    // minus those with parity 1
+    return this->collect_table(begin, end, guesses, [&](uint64_t input, uint64_t output, int64_t &sign)
+    {
+        sign = (parity(input & ip_word) ^ parity(output & fp_word)) ? -1 : 1;
+        return (first(ip.place_word(input)) << last_bits) | last(fp.inv_place_word(output));
+    });
+}
+
+// Two-ended key ranking: the top_k consistent guesses by absolute score
+std::vector<key_candidate> matsui::rank_2_both(const std::vector<int64_t> &counters, bitstring first_mask, bitstring round_mask, float bias, placement post_sbox, int top_k)
+{
+    // Both rounds are convolved at once (the kernel is a product over their bundles)
+    bitstring last_active = this->active_sboxes(round_mask, post_sbox);
+    bitstring first_active = this->active_sboxes(first_mask, post_sbox);
+    std::vector<int64_t> scores = this->score_guesses(counters, {round_mask, first_mask}, {last_active, first_active});
+    int last_bits = last_active.hamming_weight() * this->cipher.get_sbox_in();
+
+    // Master key bits fixed by a guess (both rounds may read the same bit)
+    bitstring last_known = this->guessed_key_bits(last_active, this->num_rounds - 1);
+    bitstring first_known = this->guessed_key_bits(first_active, 0);
+    bitstring known_bits = last_known | first_known;
+    bitstring shared = last_known & first_known;
+
+    // Walk the guesses by absolute score (ties by index), selecting a
+    // window twice as large whenever the top_k consistent ones are not
+    // in it yet (a window extends the previous one, so only the new
+    // guesses are checked)
+    assert(top_k > 0);
+    std::vector<key_candidate> candidates;
+    size_t checked = 0;
+    for (size_t window = top_k; checked < scores.size() && (int)candidates.size() < top_k; window *= 2)
+    {
+        std::vector<size_t> order = top_guesses(scores, window);
+        for (; checked < order.size() && (int)candidates.size() < top_k; checked++)
+        {
+            // Keep the guesses whose two round keys agree on the shared bits
+            size_t guess = order[checked];
+            bitstring last_key = this->partial_key(guess & (((size_t)1 << last_bits) - 1), last_active, this->num_rounds - 1);
+            bitstring first_key = this->partial_key(guess >> last_bits, first_active, 0);
+            if ((last_key & shared).get_string() != (first_key & shared).get_string()) continue;
+
+            // Check what is RHS, based on whether the score matches the bias (sign-wise)
+            int rhs = (scores[guess] * bias > 0) ? 0 : 1;
+            candidates.push_back(key_candidate{last_key | first_key, known_bits, scores[guess], rhs});
+        }
+    }
+    return candidates;
+}
+
+// Two-ended Attack 2
+std::vector<key_candidate> matsui::attack_2_both(uint64_t pair_count, bitstring input_mask, bitstring output_mask, bitstring first_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox, int top_k)
+{
+    // Assert
+    assert(pair_count > 0);
+
+    std::vector<int64_t> counters = this->distil_2_both(0, pair_count, input_mask, output_mask, first_mask, round_mask, ip, fp, post_sbox, prev_sbox);
+    return this->rank_2_both(counters, first_mask, round_mask, bias, post_sbox, top_k);
+}
+
+// Adaptive Attack 2: double the pairs until the top-ranked guess is settled
+bitstring matsui::attack_2_adaptive(uint64_t max_pairs, double success, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox, uint64_t &pairs_used)
+{
+    // Assert
+    assert(max_pairs > 0);
+    assert(success > 0 && success < 1);
+    bitstring active_sboxes = this->active_sboxes(round_mask, post_sbox);
+
+    // Check i may fail with probability (1 - success) / 2^i, spread
+    // over the guesses (union bound)
+    std::vector<int64_t> counters;
+    uint64_t used = 0;
+    double failure = 1 - success;
+    for (int check = 1; used < max_pairs; check++)
+    {
+        uint64_t next = std::min<uint64_t>(max_pairs, std::max<uint64_t>(ADAPTIVE_START, 2 * used));
+        std::vector<int64_t> part = this->distil_2(used, next, input_mask, output_mask, round_mask, ip, fp, post_sbox, prev_sbox);
+        if (counters.empty()) counters.assign(part.size(), 0);
+        for (size_t x = 0; x < counters.size(); x++) counters[x] += part[x];
+        used = next;
+
+        // Every score is a sum of N signs (sd at most sqrt(N)). If no
+        // score is off by more than z*sqrt(N), a gap of 2*z*sqrt(N)
+        // between the two largest |scores| fixes the top guess.
+        std::vector<int64_t> scores = this->score_guesses(counters, round_mask, active_sboxes);
+        int64_t first = 0, second = 0;
+        for (int64_t score : scores)
+        {
+            int64_t value = std::abs(score);
+            if (value > first)
             {
-                // Increment bucket
-                buckets[j] ++;
+                second = first;
+                first = value;
             }
-        } 
+            else if (value > second) second = value;
+        }
+        double tail = std::ldexp(failure, -std::min(check, 1000)) / (2.0 * scores.size());
+        double bound = 2 * normal_quantile(tail) * std::sqrt((double)used);
+        if ((double)(first - second) > bound) break;
     }
+    pairs_used = used;
+    return this->rank_2(counters, round_mask, bias, post_sbox);
+}
+
+// Union of the active S-Boxes of a basis of last-round masks
+static bitstring union_active(const std::vector<bitstring> &actives)
+{
+    bitstring active = actives[0];
+    for (size_t i = 1; i < actives.size(); i++) active = active | actives[i];
+    return active;
+}
+
+// Multidimensional data pass: joint distribution of the basis parities per S-Box input
+std::vector<int64_t> matsui::distil_md(uint64_t begin, uint64_t end, std::vector<bitstring> input_masks, std::vector<bitstring> output_masks, std::vector<bitstring> round_masks, placement ip, placement fp, placement post_sbox, placement prev_sbox)
+{
+    // Assert
+    size_t dims = input_masks.size();
+    assert(dims > 0 && dims <= MAX_DIMENSIONS);
+    assert(output_masks.size() == dims && round_masks.size() == dims);
+
+    // Bits to guess over (every S-Box active in some approximation)
+    std::vector<bitstring> actives;
+    for (bitstring &round_mask : round_masks) actives.push_back(this->active_sboxes(round_mask, post_sbox));
+    bitstring active = union_active(actives);
+    int sbox_in = this->cipher.get_sbox_in();
+    int guess_bits = active.hamming_weight() * sbox_in;
+    assert(guess_bits + (int)dims < 8 * (int)sizeof(size_t) - 1);
+    size_t size = (size_t)1 << (guess_bits + dims);
 
-    // Modify buckets (subtract num_pairs/2)
-    for (int i = 0; i < (1 << guess_bits); i++)
+    // Peel off IP and FP from the masks (so they apply to the raw texts)
+    int block_size = this->cipher.get_block_size();
+    std::vector<uint64_t> ip_words(dims);
+    std::vector<uint64_t> fp_words(dims);
+    for (size_t i = 0; i < dims; i++)
     {
-        // Subtract num_pairs/2
-        buckets[i] -= pair_count / 2;
+        assert(input_masks[i].get_size() == block_size && output_masks[i].get_size() == block_size);
+        ip_words[i] = input_word(input_masks[i], ip);
+        fp_words[i] = output_word(output_masks[i], fp);
     }
 
-    // Find the bucket index with maximum absolute value
-    int key_index = 0;
-    int max_value = 0;
-    for (int i = 0; i < (1 << guess_bits); i++)
+    // Active S-Box inputs of the ciphertext right half (FP peeled off)
+    sbox_inputs last(prev_sbox, block_size, sbox_in, this->input_shifts(active));
+
+    // Distillation: table[(x << dims) | t] is the number of pairs whose
+    // active S-Box inputs are x and whose text parities are t (bit i
+    // for approximation i)
+    return this->collect_table(begin, end, size, [&](uint64_t input, uint64_t output, int64_t &)
     {
-        // Check if the absolute value is greater than the current max
-        if (abs(buckets[i]) > max_value)
+        size_t t = 0;
+        for (size_t d = 0; d < dims; d++)
         {
-            max_value = abs(buckets[i]);
-            key_index = i;
+            t |= (size_t)(parity(input & ip_words[d]) ^ parity(output & fp_words[d])) << d;
         }
+        return (last(fp.inv_place_word(output)) << dims) | t;
+    });
+}
+
+// Multidimensional statistic of every key guess from the (merged) joint table
+std::vector<double> matsui::statistic_md(const std::vector<int64_t> &table, std::vector<bitstring> round_masks, placement post_sbox, std::vector<double> expected)
+{
+    // Layout of the guesses
+    size_t dims = round_masks.size();
+    assert(dims > 0 && dims <= MAX_DIMENSIONS);
+    size_t combos = (size_t)1 << dims;
+    std::vector<bitstring> actives;
+    for (bitstring &round_mask : round_masks) actives.push_back(this->active_sboxes(round_mask, post_sbox));
+    bitstring active = union_active(actives);
+    size_t guesses = table.size() >> dims;
+    assert(guesses << dims == table.size());
+    assert(guesses == (size_t)1 << (active.hamming_weight() * this->cipher.get_sbox_in()));
+
+    // Number of pairs
+    int64_t pair_count = 0;
+    for (int64_t count : table) pair_count += count;
+    assert(pair_count > 0);
+
+    // Walsh transform over the parity bits (the one working copy of the
+    // table): walsh[(x << dims) | a] is the distilled counter of the
+    // combined approximation a
+    std::vector<int64_t> walsh(table);
+    fwht_bits(walsh.data(), walsh.size(), 0, dims);
+
+    // Log-likelihood weights of the expected distribution. The key
+    // bits of the approximations shift it by an unknown vector k, so
+    // the weights are kept in the Walsh domain and every shift is
+    // tried below (W[a] is the transform of log(2^dims * p))
+    bool llr = !expected.empty();
+    std::vector<double> weights;
+    if (llr)
+    {
+        assert(expected.size() == combos);
+        weights = expected;
+        weights[0] = 1;
+        fwht(weights.data(), combos);
+        for (size_t z = 0; z < combos; z++)
+        {
+            assert(weights[z] > 0);
+            weights[z] = std::log(weights[z]);
+        }
+        fwht(weights.data(), combos);
     }
-    bitstring reqd_key = round_keys[key_index];
 
-    // Check what is RHS, based on whether buckets[key_index] matches the bias (sign-wise)
-    int rhs;
-    if (buckets[key_index] * bias > 0) rhs = 0;
-    else rhs = 1;
+    // The Walsh coefficient a of the joint distribution of guess j is
+    // the Algorithm 2 score of approximation a under that guess, so
+    // every distribution comes from 2^dims - 1 single rankings:
+    //   chi2[j] = sum_{a != 0} score_a[j]^2 / pair_count
+    //   llr[j]  = max_k 2^-dims * sum_a score_a[j] * W[a] * (-1)^(a.k)
+    std::vector<double> statistic(guesses, 0);
+    std::vector<double> terms;
+    if (llr) terms.assign(guesses << dims, 0);
+    for (size_t a = 0; a < combos; a++)
+    {
+        // Round mask of the combination (the constant one scores pair_count)
+        bitstring round_mask(round_masks[0].get_size());
+        for (size_t d = 0; d < dims; d++)
+        {
+            if ((a >> d) & 1) round_mask = round_mask ^ round_masks[d];
+        }
+        std::vector<int64_t> scores(guesses, pair_count);
+        if (a != 0)
+        {
+            std::vector<int64_t> counters(guesses);
+            for (size_t x = 0; x < guesses; x++) counters[x] = walsh[(x << dims) | a];
+            scores = this->score_guesses(std::move(counters), round_mask, active);
+        }
 
-    // Get key schedule (last round)
-    std::vector<int> final_schedule = this->cipher.get_key_schedule()[this->num_rounds - 1];
+        for (size_t j = 0; j < guesses; j++)
+        {
+            if (llr) terms[(j << dims) | a] = (double)scores[j] * weights[a];
+            else if (a != 0) statistic[j] += (double)scores[j] * (double)scores[j] / (double)pair_count;
+        }
+    }
 
-    // Create a partial key
-    bitstring partial_key = bitstring(this->cipher.get_key_size());
-    for (int i = 0; i < sbox_in*num_sboxes ; i++)
+    // Best shift of the expected distribution per guess
+    if (llr)
     {
-        // Set the bits in the partial key
-        partial_key.set_bit(final_schedule[i], reqd_key.get_bit(i));
+        fwht_bits(terms.data(), terms.size(), 0, dims);
+        for (size_t j = 0; j < guesses; j++)
+        {
+            double best = terms[j << dims];
+            for (size_t k = 1; k < combos; k++) best = std::max(best, terms[(j << dims) | k]);
+            statistic[j] = best / (double)combos;
+        }
     }
+    return statistic;
+}
 
-    // Return the partial key
-    return partial_key;
+// Multidimensional key ranking (partial key of the largest statistic)
+bitstring matsui::rank_md(const std::vector<int64_t> &table, std::vector<bitstring> round_masks, placement post_sbox, std::vector<double> expected)
+{
+    std::vector<double> statistic = this->statistic_md(table, round_masks, post_sbox, expected);
+    size_t key_index = std::max_element(statistic.begin(), statistic.end()) - statistic.begin();
+
+    std::vector<bitstring> actives;
+    for (bitstring &round_mask : round_masks) actives.push_back(this->active_sboxes(round_mask, post_sbox));
+    return this->partial_key(key_index, union_active(actives), this->num_rounds - 1);
+}
+
+// Multidimensional Attack 2
+bitstring matsui::attack_md(uint64_t pair_count, std::vector<bitstring> input_masks, std::vector<bitstring> output_masks, std::vector<bitstring> round_masks, placement ip, placement fp, placement post_sbox, placement prev_sbox, std::vector<double> expected)
+{
+    // Assert
+    assert(pair_count > 0);
+
+    std::vector<int64_t> table = this->distil_md(0, pair_count, input_masks, output_masks, round_masks, ip, fp, post_sbox, prev_sbox);
+    return this->rank_md(table, round_masks, post_sbox, expected);
 }
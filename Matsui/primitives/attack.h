@@ -6,12 +6,107 @@
 // Library Imports
 #include <iostream>
 #include <vector>
+#include <cstdint>
+#include <functional>
 
 // Custom Library Imports
 #include "s_box.h"
 #include "placement.h"
 #include "bitstring.h"
+#include "fixed_bitstring.h"
 #include "feistel.h"
+#include "work_pool.h"
+#include "corpus.h"
+#include "parity.h"
+#include "key_enum.h"
+
+// Number of pairs generated and encrypted per batch (one PRNG stream each)
+#define BATCH_SIZE 4096
+
+// First range of the adaptive attacks (doubled until the result is settled;
+// ranges need not align with BATCH_SIZE)
+#define ADAPTIVE_START 64
+
+// Largest basis of a multidimensional attack (joint table of 2^(k + m) counters)
+#define MAX_DIMENSIONS 12
+
+/*
+ * Data collection:
+ * Pairs are generated in chunks of BATCH_SIZE on a work-stealing
+ * pool. Chunk c draws its plaintexts from the xoshiro256** stream
+ * (seed, c), and every worker keeps its own counters, which are
+ * merged at the end. The data, and so every result, depends on the
+ * seed only, not on the number of threads. With a corpus set, the
+ * pairs are read from the mapping in the same chunks instead.
+ * Memory: the table passes (histogram, distil_2, distil_2_both,
+ * distil_md, all on collect_table) give every worker its own full
+ * table of 2^k counters, so they hold threads * 2^k * 8 bytes at
+ * peak (8 GiB at k = 24 on 64 threads); pick the thread count
+ * (set_threads) to fit large k.
+ */
+
+/*
+ * Sample ranges:
+ * In PRF mode plaintext i is prf64(seed, i), so any range of
+ * samples can be regenerated on its own. The data passes (count_1,
+ * distil_2) take a range [begin, end) and return counters that add
+ * up over disjoint ranges; decide_1 and rank_2 finish the attack
+ * from the merged counters. A huge run thus splits into chunks that
+ * are resumable and can be checked one by one. Ranges also work in
+ * the other modes (sample i is word i % BATCH_SIZE of its chunk, or
+ * pair i of the corpus).
+ */
+
+/*
+ * Correlation spectrum:
+ * Bits are chosen on the plaintext (after IP) and on the ciphertext
+ * (before FP); index bit k - 1 - j holds chosen bit j of
+ * input_bits ++ output_bits (big-endian, like masks elsewhere). A
+ * histogram of the chosen bits over the data, transformed by an
+ * in-place FWHT, gives the experimental correlation of every mask on
+ * them at once: entry u is the correlation of u over the same index.
+ */
+
+/*
+ * Two-ended attack:
+ * With a mask on the first round function output as well
+ * (first_mask), the approximation reads
+ *   input.P ^ output.C ^ first.F(P_R, K_1) ^ round.F(C_R, K_r)
+ * and the key bits of the active S-Boxes of both rounds are guessed.
+ * One pass distils the counters over the first-round S-Box inputs
+ * (plaintext side, high index bits) and the last-round ones
+ * (ciphertext side, low bits). The kernel is a product over the
+ * bundles of both rounds, so the per-bundle Walsh convolution scores
+ * every pair of guesses in O((k1 + k2) * 2^(k1 + k2)). Guesses whose
+ * two round keys disagree on a shared master key bit are dropped.
+ */
+
+/*
+ * Adaptive attacks:
+ * Instead of a fixed pair count, the samples [0, 2^i * ADAPTIVE_START)
+ * are taken range by range (up to max_pairs) and the result is
+ * checked after every range: the running bias estimate of Algorithm 1
+ * against its normal confidence bound, and the gap between the two
+ * best Algorithm 2 scores. The i-th check is allowed a failure
+ * probability of (1 - success) / 2^i, so the stopped result is right
+ * with probability about success (the bounds are conservative). The
+ * number of pairs used is returned in pairs_used.
+ */
+
+/*
+ * Multidimensional attack:
+ * A basis of m approximations (input, output and last-round masks)
+ * spans a subspace of 2^m - 1 combined approximations. One pass
+ * distils, per value x of the active S-Box inputs (the union over the
+ * basis), the joint distribution of the m text parities. Per key
+ * guess, the Walsh coefficients of the joint distribution of the m
+ * full parities are the Algorithm 2 scores of the combinations, so
+ * the guesses are ranked by chi2 (distance from uniform, no model
+ * needed) or by LLR against the expected correlations of the
+ * combinations (index a, bit i for approximation i; the key bits of
+ * the approximations only shift the distribution, so the best shift
+ * is taken).
+ */
 
 // Class to perform Matsui's attack on Feistel Network
 class matsui
@@ -19,15 +114,91 @@ class matsui
   private:
     feistel cipher;                   // Feistel cipher
     int num_rounds;                 // Number of rounds
+    bool fast_ranking;              // Rank attack_2 key guesses in the Walsh domain
+    uint64_t seed;                  // Master seed of the generated data
+    int num_threads;                // Data collection threads (0 = all cores)
+    bool prf_mode;                  // Plaintext i is prf64(seed, i)
+    const corpus *data;             // Known pairs to read (null = generate)
+
+    // Visit the pairs [begin, end), visit(worker, inputs, outputs, count) per batch
+    void collect(uint64_t begin, uint64_t end, const work_pool &workers,
+                 const std::function<void(int, const uint64_t *, const uint64_t *, size_t)> &visit);
+
+    // Table of size counters over [begin, end), index(input, output, sign) per pair
+    template <typename Index>
+    std::vector<int64_t> collect_table(uint64_t begin, uint64_t end, size_t size, Index index);
+
+    // Active S-Boxes of a last-round mask
+    bitstring active_sboxes(bitstring round_mask, placement post_sbox);
+    std::vector<int> input_shifts(bitstring active_sboxes);
+
+    // Algorithm 2 score of every guess, and the partial key of a guess
+    std::vector<int64_t> score_guesses(std::vector<int64_t> counters, bitstring round_mask, bitstring active_sboxes);
+    std::vector<int64_t> score_guesses(std::vector<int64_t> counters, std::vector<bitstring> round_masks, std::vector<bitstring> actives);
+    bitstring partial_key(size_t guess, bitstring active_sboxes, int round);
+    bitstring guessed_key_bits(bitstring active_sboxes, int round);
 
   public:
     // Constructors & Destructors
     matsui(feistel cipher, int num_rounds);
     ~matsui();
 
+    // Key ranking mode of attack_2 (Walsh domain O(k*2^k), or direct O(2^2k))
+    void set_fast_ranking(bool enable) { this->fast_ranking = enable; }
+    bool get_fast_ranking() { return this->fast_ranking; }
+
+    // Data collection (master seed, defaults to rand(); 0 threads = all cores)
+    void set_seed(uint64_t seed) { this->seed = seed; }
+    uint64_t get_seed() { return this->seed; }
+    void set_threads(int threads) { this->num_threads = threads; }
+    int get_threads() { return this->num_threads; }
+    void set_prf_mode(bool enable) { this->prf_mode = enable; }
+    bool get_prf_mode() { return this->prf_mode; }
+    void set_corpus(const corpus *data);    // Not owned, null to generate again
+    const corpus *get_corpus() { return this->data; }
+
     // Accessors
-    int attack_1(int pair_count, bitstring input_mask, bitstring output_mask, float bias, placement ip, placement fp);
-    bitstring attack_2(int pair_count, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox);
+    int attack_1(uint64_t pair_count, bitstring input_mask, bitstring output_mask, float bias, placement ip, placement fp);
+    bitstring attack_2(uint64_t pair_count, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox);
+    int attack_1_adaptive(uint64_t max_pairs, double success, bitstring input_mask, bitstring output_mask, float bias, placement ip, placement fp, uint64_t &pairs_used);
+    bitstring attack_2_adaptive(uint64_t max_pairs, double success, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox, uint64_t &pairs_used);
+    std::vector<key_candidate> attack_2_candidates(uint64_t pair_count, bitstring input_mask, bitstring output_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox, int top_k);
+    std::vector<key_candidate> attack_2_both(uint64_t pair_count, bitstring input_mask, bitstring output_mask, bitstring first_mask, bitstring round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox, int top_k);
+    bitstring attack_md(uint64_t pair_count, std::vector<bitstring> input_masks, std::vector<bitstring> output_masks, std::vector<bitstring> round_masks, placement ip, placement fp, placement post_sbox, placement prev_sbox, std::vector<double> expected = {});
+
+    // Data passes over the samples [begin, end) (results of disjoint ranges add up)
+    uint64_t count_1(uint64_t begin, uint64_t end, bitstring input_mask, bitstring output_mask, placement ip, placement fp);
+    std::vector<uint64_t> count_1_masks(uint64_t begin, uint64_t end, std::vector<bitstring> input_masks, std::vector<bitstring> output_masks, placement ip, placement fp);
+    std::vector<int64_t> histogram(uint64_t begin, uint64_t end, std::vector<int> input_bits, std::vector<int> output_bits, placement ip, placement fp);
+    std::vector<int64_t> distil_2(uint64_t begin, uint64_t end, bitstring input_mask, bitstring output_mask, bitstring round_mask, placement ip, placement fp, placement post_sbox, placement prev_sbox);
+    std::vector<int64_t> distil_2_both(uint64_t begin, uint64_t end, bitstring input_mask, bitstring output_mask, bitstring first_mask, bitstring round_mask, placement ip, placement fp, placement post_sbox, placement prev_sbox);
+    std::vector<int64_t> distil_md(uint64_t begin, uint64_t end, std::vector<bitstring> input_masks, std::vector<bitstring> output_masks, std::vector<bitstring> round_masks, placement ip, placement fp, placement post_sbox, placement prev_sbox);
+
+    // Decisions from (merged) data passes
+    int decide_1(uint64_t count, uint64_t pair_count, float bias);
+    bitstring rank_2(const std::vector<int64_t> &counters, bitstring round_mask, float bias, placement post_sbox);
+    std::vector<key_candidate> rank_2_candidates(const std::vector<int64_t> &counters, bitstring round_mask, float bias, placement post_sbox, int top_k);
+    std::vector<key_candidate> rank_2_both(const std::vector<int64_t> &counters, bitstring first_mask, bitstring round_mask, float bias, placement post_sbox, int top_k);
+
+    // Multidimensional ranking (chi2 if expected is empty, else LLR; larger is better)
+    std::vector<double> statistic_md(const std::vector<int64_t> &table, std::vector<bitstring> round_masks, placement post_sbox, std::vector<double> expected = {});
+    bitstring rank_md(const std::vector<int64_t> &table, std::vector<bitstring> round_masks, placement post_sbox, std::vector<double> expected = {});
+
+    // Correlation spectrum of the chosen bits over [begin, end) (2^k entries)
+    std::vector<double> spectrum(uint64_t begin, uint64_t end, std::vector<int> input_bits, std::vector<int> output_bits, placement ip, placement fp);
+    void spectrum_masks(size_t index, std::vector<int> input_bits, std::vector<int> output_bits, bitstring &input_mask, bitstring &output_mask);
+
+    // Fixed-width mask overloads
+    template <int N>
+    int attack_1(uint64_t pair_count, const fixed_bitstring<N> &input_mask, const fixed_bitstring<N> &output_mask, float bias, placement ip, placement fp)
+    {
+        return this->attack_1(pair_count, input_mask.to_bitstring(), output_mask.to_bitstring(), bias, ip, fp);
+    }
+    template <int N, int M>
+    bitstring attack_2(uint64_t pair_count, const fixed_bitstring<N> &input_mask, const fixed_bitstring<N> &output_mask, const fixed_bitstring<M> &round_mask, float bias, placement ip, placement fp, placement post_sbox, placement prev_sbox)
+    {
+        return this->attack_2(pair_count, input_mask.to_bitstring(), output_mask.to_bitstring(), round_mask.to_bitstring(), bias, ip, fp, post_sbox, prev_sbox);
+    }
 
 };
 
@@ -0,0 +1,363 @@
+// Implementation of the bitsliced Feistel engine
+#include "bitslice.h"
+
+// Include Libraries
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+// Limits for the on-stack slice buffers
+#define SLICE_MAX_BLOCK 64   // Packed blocks are 64-bit words
+#define SLICE_MAX_LAYER 256  // Size of the S-Box layer input
+#define SLICE_MAX_SBOX_IN 8  // S-Box input size (monomial table)
+
+// Transpose a 64x64 bit matrix in place
+// (bit 63-c of rows[r] is swapped with bit 63-r of rows[c])
+void transpose_64(uint64_t rows[64])
+{
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, mask ^= (mask << j))
+    {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j)
+        {
+            uint64_t t = (rows[k] ^ (rows[k | j] >> j)) & mask;
+            rows[k] ^= t;
+            rows[k | j] ^= (t << j);
+        }
+    }
+}
+
+// Pack up to SLICE_LANES blocks into block_size slices
+void pack_slices(const uint64_t *blocks, size_t count, int block_size, slice_t *slices)
+{
+    assert(count <= SLICE_LANES);
+    assert(block_size > 0 && block_size <= 64);
+
+    // Transpose one 64-lane word at a time
+    for (int w = 0; w < SLICE_WORDS; w++)
+    {
+        uint64_t rows[64];
+        for (int j = 0; j < 64; j++)
+        {
+            size_t index = 64*w + j;
+            rows[j] = (index < count) ? blocks[index] : 0;
+        }
+        transpose_64(rows);
+
+        // Bit i of the block sits in row (i + 64 - block_size)
+        for (int i = 0; i < block_size; i++)
+        {
+            std::memcpy(reinterpret_cast<char *>(&slices[i]) + 8*w, &rows[i + 64 - block_size], 8);
+        }
+    }
+}
+
+// Unpack block_size slices into up to SLICE_LANES blocks
+void unpack_slices(const slice_t *slices, int block_size, uint64_t *blocks, size_t count)
+{
+    assert(count <= SLICE_LANES);
+    assert(block_size > 0 && block_size <= 64);
+
+    for (int w = 0; w < SLICE_WORDS; w++)
+    {
+        // Skip words without any requested lane
+        if ((size_t)(64*w) >= count) break;
+
+        uint64_t rows[64] = {0};
+        for (int i = 0; i < block_size; i++)
+        {
+            std::memcpy(&rows[i + 64 - block_size], reinterpret_cast<const char *>(&slices[i]) + 8*w, 8);
+        }
+        transpose_64(rows);
+
+        for (int j = 0; j < 64; j++)
+        {
+            size_t index = 64*w + j;
+            if (index < count) blocks[index] = rows[j];
+        }
+    }
+}
+
+// Constructors and Destructors
+bitslice::bitslice()
+{
+    // Default constructor (unusable engine)
+    this->supported = false;
+    this->block_size = 0;
+    this->max_rounds = 0;
+    this->num_sboxes = 0;
+    this->sbox_in = 0;
+    this->sbox_out = 0;
+    this->key_size = 0;
+}
+
+bitslice::bitslice(int block_size, int max_rounds, placement ip, placement fp,
+                   std::vector<s_box> sboxes, placement prev_sbox, placement post_sbox,
+                   int key_size, std::vector<std::vector<int>> key_schedule)
+{
+    // Check if the parameters are valid
+    assert(block_size > 0 && block_size % 2 == 0);
+    assert((int)key_schedule.size() == max_rounds);
+    assert(sboxes.size() > 0);
+
+    // Populate
+    this->block_size = block_size;
+    this->max_rounds = max_rounds;
+    this->num_sboxes = sboxes.size();
+    this->sbox_in = prev_sbox.get_output_size() / this->num_sboxes;
+    this->sbox_out = post_sbox.get_output_size() / this->num_sboxes;
+    this->key_size = key_size;
+    this->ip = ip.get_placement_table();
+    this->ip_inv = ip.get_inverse_table();
+    this->fp = fp.get_placement_table();
+    this->fp_inv = fp.get_inverse_table();
+    this->prev_sbox = prev_sbox.get_placement_table();
+    this->post_sbox = post_sbox.get_placement_table();
+    this->key_schedule = key_schedule;
+
+    // Only blocks that fit a packed word (and layers that fit the stack buffers)
+    this->supported = (block_size <= SLICE_MAX_BLOCK)
+                      && (this->sbox_in * this->num_sboxes <= SLICE_MAX_LAYER)
+                      && (this->sbox_in <= SLICE_MAX_SBOX_IN);
+    if (!this->supported) return;
+
+    // Algebraic normal form of every S-Box output bit (Moebius transform)
+    int N = (1 << this->sbox_in);
+    this->anf.resize(this->num_sboxes);
+    for (int i = 0; i < this->num_sboxes; i++)
+    {
+        std::vector<int> table = sboxes[i].get_table();
+        this->anf[i].resize(this->sbox_out);
+        for (int o = 0; o < this->sbox_out; o++)
+        {
+            // Truth table of output bit o (big-endian within the S-Box output)
+            std::vector<int> coeffs(N);
+            for (int x = 0; x < N; x++) coeffs[x] = (table[x] >> (this->sbox_out - 1 - o)) & 1;
+
+            // Moebius transform
+            for (int b = 0; b < this->sbox_in; b++)
+            {
+                for (int x = 0; x < N; x++)
+                {
+                    if ((x >> b) & 1) coeffs[x] ^= coeffs[x ^ (1 << b)];
+                }
+            }
+
+            // Keep monomials with non-zero coefficients
+            for (int m = 0; m < N; m++)
+            {
+                if (coeffs[m]) this->anf[i][o].push_back(m);
+            }
+        }
+    }
+}
+
+bitslice::~bitslice()
+{
+    // Destructor Logic
+}
+
+// Expand the master key into round key slices
+void bitslice::set_key(const bitstring &master_key)
+{
+    // Check if the key is valid
+    if (!this->supported) return;
+    assert(master_key.get_size() == this->key_size);
+
+    // All-zero and all-one slices
+    slice_t zero = {};
+    slice_t ones = ~zero;
+
+    // One slice per round key bit
+    int layer = this->sbox_in * this->num_sboxes;
+    this->round_keys.assign(this->max_rounds * layer, zero);
+    for (int r = 0; r < this->max_rounds; r++)
+    {
+        for (int k = 0; k < layer; k++)
+        {
+            if (master_key.get_bit(this->key_schedule[r][k])) this->round_keys[r*layer + k] = ones;
+        }
+    }
+}
+
+// Apply Round Function on slices (Y = F(X, K))
+void bitslice::round_function(const slice_t *input, const slice_t *round_key, slice_t *output) const
+{
+    slice_t mixed[SLICE_MAX_LAYER];
+    slice_t sbox_output[SLICE_MAX_BLOCK / 2];
+    slice_t monomials[1 << SLICE_MAX_SBOX_IN];
+    slice_t zero = {};
+
+    // Expansion and key mixing layers
+    int layer = this->sbox_in * this->num_sboxes;
+    for (int k = 0; k < layer; k++) mixed[k] = input[this->prev_sbox[k]] ^ round_key[k];
+
+    // S-Box layer
+    int N = (1 << this->sbox_in);
+    monomials[0] = ~zero;
+    for (int i = 0; i < this->num_sboxes; i++)
+    {
+        // Input variable b (value bit b) is slice sbox_in - 1 - b of the S-Box
+        const slice_t *vars = mixed + i*this->sbox_in;
+        for (int m = 1; m < N; m++)
+        {
+            int b = __builtin_ctz(m);
+            monomials[m] = monomials[m & (m - 1)] & vars[this->sbox_in - 1 - b];
+        }
+
+        // Output bits are xors of monomials
+        for (int o = 0; o < this->sbox_out; o++)
+        {
+            slice_t acc = zero;
+            const std::vector<int> &terms = this->anf[i][o];
+            for (size_t t = 0; t < terms.size(); t++) acc ^= monomials[terms[t]];
+            sbox_output[i*this->sbox_out + o] = acc;
+        }
+    }
+
+    // Post-S-Box layer
+    for (int p = 0; p < this->block_size/2; p++) output[p] = sbox_output[this->post_sbox[p]];
+}
+
+// Encrypt slices in place
+void bitslice::encrypt_slices(slice_t *state, int rounds, const slice_t *keys) const
+{
+    slice_t permuted[SLICE_MAX_BLOCK];
+    slice_t round_output[SLICE_MAX_BLOCK / 2];
+    int half = this->block_size/2;
+    int layer = this->sbox_in * this->num_sboxes;
+
+    // Apply initial permutation
+    for (int i = 0; i < this->block_size; i++) permuted[i] = state[this->ip[i]];
+
+    // Apply rounds
+    slice_t *left_half = permuted;
+    slice_t *right_half = permuted + half;
+    for (int r = 0; r < rounds; r++)
+    {
+        this->round_function(right_half, keys + r*layer, round_output);
+        for (int i = 0; i < half; i++) left_half[i] ^= round_output[i];
+        if (r < rounds - 1) std::swap(left_half, right_half);
+    }
+
+    // Combine halves and apply final permutation
+    slice_t combined[SLICE_MAX_BLOCK];
+    for (int i = 0; i < half; i++)
+    {
+        combined[i] = left_half[i];
+        combined[i + half] = right_half[i];
+    }
+    for (int i = 0; i < this->block_size; i++) state[i] = combined[this->fp[i]];
+}
+
+// Decrypt slices in place
+void bitslice::decrypt_slices(slice_t *state, int rounds, const slice_t *keys) const
+{
+    slice_t permuted[SLICE_MAX_BLOCK];
+    slice_t round_output[SLICE_MAX_BLOCK / 2];
+    int half = this->block_size/2;
+    int layer = this->sbox_in * this->num_sboxes;
+
+    // Undo final permutation
+    for (int i = 0; i < this->block_size; i++) permuted[i] = state[this->fp_inv[i]];
+
+    // Apply rounds in reverse order
+    slice_t *left_half = permuted;
+    slice_t *right_half = permuted + half;
+    for (int r = rounds - 1; r >= 0; r--)
+    {
+        this->round_function(right_half, keys + r*layer, round_output);
+        for (int i = 0; i < half; i++) left_half[i] ^= round_output[i];
+        if (r > 0) std::swap(left_half, right_half);
+    }
+
+    // Combine halves and undo initial permutation
+    slice_t combined[SLICE_MAX_BLOCK];
+    for (int i = 0; i < half; i++)
+    {
+        combined[i] = left_half[i];
+        combined[i + half] = right_half[i];
+    }
+    for (int i = 0; i < this->block_size; i++) state[i] = combined[this->ip_inv[i]];
+}
+
+// Encrypt packed blocks
+void bitslice::encrypt(const uint64_t *input, uint64_t *output, size_t count, int rounds) const
+{
+    // Check if the engine is usable
+    assert(this->supported);
+    assert(!this->round_keys.empty());
+    assert(rounds <= this->max_rounds);
+
+    slice_t state[SLICE_MAX_BLOCK];
+    for (size_t base = 0; base < count; base += SLICE_LANES)
+    {
+        size_t n = std::min((size_t)SLICE_LANES, count - base);
+        pack_slices(input + base, n, this->block_size, state);
+        this->encrypt_slices(state, rounds, this->round_keys.data());
+        unpack_slices(state, this->block_size, output + base, n);
+    }
+}
+
+// Decrypt packed blocks
+void bitslice::decrypt(const uint64_t *input, uint64_t *output, size_t count, int rounds) const
+{
+    // Check if the engine is usable (decryption needs invertible IP/FP)
+    assert(this->supported);
+    assert(!this->round_keys.empty());
+    assert(rounds <= this->max_rounds);
+    assert((int)this->ip_inv.size() == this->block_size && (int)this->fp_inv.size() == this->block_size);
+
+    slice_t state[SLICE_MAX_BLOCK];
+    for (size_t base = 0; base < count; base += SLICE_LANES)
+    {
+        size_t n = std::min((size_t)SLICE_LANES, count - base);
+        pack_slices(input + base, n, this->block_size, state);
+        this->decrypt_slices(state, rounds, this->round_keys.data());
+        unpack_slices(state, this->block_size, output + base, n);
+    }
+}
+
+// Encrypt one packed block under SLICE_LANES master keys
+void bitslice::encrypt_keys(uint64_t plaintext, const slice_t *key_slices, slice_t *ciphertext, int rounds) const
+{
+    // Check if the engine is usable
+    assert(this->supported);
+    assert(rounds <= this->max_rounds);
+
+    slice_t permuted[SLICE_MAX_BLOCK];
+    slice_t round_key[SLICE_MAX_LAYER];
+    slice_t round_output[SLICE_MAX_BLOCK / 2];
+    slice_t zero = {};
+    int half = this->block_size/2;
+    int layer = this->sbox_in * this->num_sboxes;
+
+    // Broadcast the plaintext and apply initial permutation
+    for (int i = 0; i < this->block_size; i++)
+    {
+        permuted[i] = ((plaintext >> (this->block_size - 1 - this->ip[i])) & 1) ? ~zero : zero;
+    }
+
+    // Apply rounds (round key slices gathered from the master key slices)
+    slice_t *left_half = permuted;
+    slice_t *right_half = permuted + half;
+    for (int r = 0; r < rounds; r++)
+    {
+        const std::vector<int> &schedule = this->key_schedule[r];
+        for (int k = 0; k < layer; k++) round_key[k] = key_slices[schedule[k]];
+        this->round_function(right_half, round_key, round_output);
+        for (int i = 0; i < half; i++) left_half[i] ^= round_output[i];
+        if (r < rounds - 1) std::swap(left_half, right_half);
+    }
+
+    // Combine halves and apply final permutation
+    slice_t combined[SLICE_MAX_BLOCK];
+    for (int i = 0; i < half; i++)
+    {
+        combined[i] = left_half[i];
+        combined[i + half] = right_half[i];
+    }
+    for (int i = 0; i < this->block_size; i++) ciphertext[i] = combined[this->fp[i]];
+}
@@ -0,0 +1,115 @@
+// Class to evaluate Feistel networks on many blocks at once
+
+/*
+ * Bitslicing:
+ * Every bit position of the block is stored in its own machine
+ * word (a "slice"), with lane j of the slice holding that bit of
+ * block j. Placement layers (IP, FP, expansion, post-S-Box) then
+ * become free index remaps, key mixing becomes a word xor and
+ * every S-Box is evaluated on all lanes at once through its
+ * algebraic normal form.
+ */
+
+/*
+ * Key slicing:
+ * encrypt_keys runs the other way around: every lane holds the same
+ * block under its own master key. The round key slices are gathered
+ * from the master key slices through the key schedule, one round at
+ * a time, so exhaustive key searches test SLICE_LANES keys per pass.
+ */
+
+/*
+ * Lanes:
+ * A slice is a plain 64-bit word, or a GCC vector of 64-bit words
+ * when SSE2 (128 lanes) or AVX2 (256 lanes) is available.
+ */
+
+/*
+ * Packed blocks:
+ * Blocks are exchanged as uint64_t words holding the bitstring in
+ * big-endian order, i.e. bit i of a bitstring of size n is bit
+ * (n - 1 - i) of the word. Hence block sizes are limited to 64.
+ */
+
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+// Standard Library Imports
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Custom Library Imports
+#include "s_box.h"
+#include "placement.h"
+#include "bitstring.h"
+
+// Slice type (one bit position of SLICE_LANES blocks)
+#if defined(__AVX2__)
+typedef uint64_t slice_t __attribute__((vector_size(32)));
+#define SLICE_LANES 256
+#elif defined(__SSE2__)
+typedef uint64_t slice_t __attribute__((vector_size(16)));
+#define SLICE_LANES 128
+#else
+typedef uint64_t slice_t;
+#define SLICE_LANES 64
+#endif
+#define SLICE_WORDS (SLICE_LANES / 64)
+
+// Transpose helpers (packed blocks <-> slices)
+void transpose_64(uint64_t rows[64]);
+void pack_slices(const uint64_t *blocks, size_t count, int block_size, slice_t *slices);
+void unpack_slices(const slice_t *slices, int block_size, uint64_t *blocks, size_t count);
+
+class bitslice
+{
+  private:
+    bool supported;                             // Block fits in a packed word
+    int block_size;                             // Block size
+    int max_rounds;                             // Maximum number of rounds
+    int num_sboxes;                             // Number of S-Boxes
+    int sbox_in;                                // Input size of S-Boxes
+    int sbox_out;                               // Output size of S-Boxes
+    int key_size;                               // Key size
+    std::vector<int> ip;                        // Initial Permutation table
+    std::vector<int> ip_inv;                    // Inverse of IP
+    std::vector<int> fp;                        // Final Permutation table
+    std::vector<int> fp_inv;                    // Inverse of FP
+    std::vector<int> prev_sbox;                 // Expansion table
+    std::vector<int> post_sbox;                 // Post-S-Box table
+    std::vector<std::vector<int>> key_schedule; // Key schedule
+    std::vector<std::vector<std::vector<int>>> anf; // ANF monomials [sbox][output bit]
+    std::vector<slice_t> round_keys;            // Round key slices (max_rounds x sbox layer)
+
+    // Sliced primitives
+    void round_function(const slice_t *input, const slice_t *round_key, slice_t *output) const;
+    void encrypt_slices(slice_t *state, int rounds, const slice_t *keys) const;
+    void decrypt_slices(slice_t *state, int rounds, const slice_t *keys) const;
+
+  public:
+    // Constructors & Destructors
+    bitslice();
+    bitslice(int block_size, int max_rounds, placement ip, placement fp,
+             std::vector<s_box> sboxes, placement prev_sbox, placement post_sbox,
+             int key_size, std::vector<std::vector<int>> key_schedule);
+    ~bitslice();
+
+    // Accessors
+    bool is_supported() const { return this->supported; }
+    int get_block_size() const { return this->block_size; }
+
+    // Key setup (expands the master key into round key slices)
+    void set_key(const bitstring &master_key);
+
+    // Encryption & Decryption of packed blocks (input and output may alias)
+    void encrypt(const uint64_t *input, uint64_t *output, size_t count, int rounds) const;
+    void decrypt(const uint64_t *input, uint64_t *output, size_t count, int rounds) const;
+
+    // Encryption of one packed block under SLICE_LANES keys (slice b of key_slices
+    // holds master key bit b of every lane; ciphertext gets block_size slices)
+    void encrypt_keys(uint64_t plaintext, const slice_t *key_slices, slice_t *ciphertext, int rounds) const;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <cassert>
 
 // Constructors
@@ -13,17 +14,56 @@ bitstring::bitstring(int size)
     // Check if the size is valid
     assert(size > 0);
 
-    // Initialize member variables
-    this->size = size;
-    this->num_chunks = (size/CHUNK_SIZE) + ((size % CHUNK_SIZE) ? 1 : 0); // Calculate number of chunks
-    this->chunks.resize(this->num_chunks, 0); // Initialize chunks to zero
+    // Initialize member variables and zeroed chunks
+    this->allocate(size);
+}
+
+// Copy constructor
+bitstring::bitstring(const bitstring &other)
+{
+    this->allocate(other.size);
+    std::copy(other.chunks, other.chunks + other.num_chunks, this->chunks);
+}
+
+// Move constructor (steals heap chunks, copies inline ones)
+bitstring::bitstring(bitstring &&other) noexcept
+{
+    this->size = other.size;
+    this->num_chunks = other.num_chunks;
+    if (other.chunks == other.inline_chunks)
+    {
+        this->chunks = this->inline_chunks;
+        std::copy(other.chunks, other.chunks + other.num_chunks, this->chunks);
+        return;
+    }
+    this->chunks = other.chunks;
+
+    // Leave the other empty
+    other.chunks = other.inline_chunks;
+    other.size = 0;
+    other.num_chunks = 0;
 }
 
 // Destructor
 bitstring::~bitstring()
 {
-    // Destructor does not need to do anything
-    // since chunks are automatically deallocated
+    this->release();
+}
+
+// Point chunks at storage for size bits (zeroed)
+void bitstring::allocate(int size)
+{
+    this->size = size;
+    this->num_chunks = (size/CHUNK_SIZE) + ((size % CHUNK_SIZE) ? 1 : 0); // Calculate number of chunks
+    this->chunks = (this->num_chunks <= (int)INLINE_CHUNKS) ? this->inline_chunks : new int[this->num_chunks];
+    std::fill(this->chunks, this->chunks + this->num_chunks, 0); // Initialize chunks to zero
+}
+
+// Free the heap storage, if any
+void bitstring::release()
+{
+    if (this->chunks != this->inline_chunks) delete[] this->chunks;
+    this->chunks = this->inline_chunks;
 }
 
 // Set bit in big-endian
@@ -89,23 +129,39 @@ int bitstring::get_bit(int index) const
 
 // Get slice in big-endian
 bitstring bitstring::get_slice(int start, int end) const
+{
+    // Create a new bitstring for the slice
+    bitstring slice(end - start);
+    this->slice_into(start, end, slice);
+
+    return slice;
+}
+
+// Get slice in big-endian into out
+void bitstring::slice_into(int start, int end, bitstring &out) const
 {
     // Check if the start and end indices are valid
     assert(start >= 0 && end <= this->size);
     assert(start < end);
+    assert(out.size == end - start);
 
-    // Create a new bitstring for the slice
-    bitstring slice(end - start);
+    // Word-level path
+    if (this->size <= 64)
+    {
+        uint64_t mask = (out.size == 64) ? ~0ULL : (1ULL << out.size) - 1;
+        out.set_uint64((this->get_uint64() >> (this->size - end)) & mask);
+        return;
+    }
 
     // Iterate
     for (int i = start; i < end; i++)
     {
         // Set the bit in the slice
-        slice.set_bit(i - start, this->get_bit(i));
+        out.set_bit(i - start, this->get_bit(i));
     }
 
-    return slice;
-} 
+    return;
+}
 
 // Get small slice in big-endian (int)
 int bitstring::get_slice_int(int start, int end) const
@@ -126,7 +182,34 @@ int bitstring::get_slice_int(int start, int end) const
     }
 
     return value;
-} 
+}
+
+// Get as packed word (bit i is bit size-1-i of the word)
+uint64_t bitstring::get_uint64() const
+{
+    // Check if the size is valid
+    assert(this->size <= 64);
+
+    // Gather the (at most two) chunks into the top of a word
+    uint64_t value = (uint64_t)(uint32_t)this->chunks[0] << 32;
+    if (this->size > (int)CHUNK_SIZE) value |= (uint64_t)(uint32_t)this->chunks[1];
+
+    return value >> (64 - this->size);
+}
+
+// Set from packed word (bit i is bit size-1-i of the word)
+void bitstring::set_uint64(uint64_t value)
+{
+    // Check if the size is valid
+    assert(this->size <= 64);
+
+    // Move the value to the top of the word and split it into chunks
+    value <<= (64 - this->size);
+    this->chunks[0] = (int)(uint32_t)(value >> 32);
+    if (this->size > (int)CHUNK_SIZE) this->chunks[1] = (int)(uint32_t)value;
+
+    return;
+}
 
 // Get string in big-endian
 std::string bitstring::get_string()
@@ -208,15 +291,56 @@ bitstring bitstring::operator^(const bitstring &other)
     return result;
 }
 
+// Bitwise XOR into this
+void bitstring::xor_inplace(const bitstring &other)
+{
+    // Check if the sizes match
+    assert(this->size == other.size);
+
+    // Iterate
+    for (int i = 0; i < this->num_chunks; i++)
+    {
+        this->chunks[i] ^= other.chunks[i];
+    }
+
+    return;
+}
+
 // Assignment operator
 bitstring &bitstring::operator=(const bitstring &other)
 {
-    // Copy the size
+    if (this == &other) return *this;
+
+    // Reuse the storage if the number of chunks matches
+    if (this->num_chunks != other.num_chunks)
+    {
+        this->release();
+        this->allocate(other.size);
+    }
     this->size = other.size;
 
     // Copy the chunks
+    std::copy(other.chunks, other.chunks + other.num_chunks, this->chunks);
+
+    return *this;
+}
+
+// Move assignment operator (steals heap chunks, copies inline ones)
+bitstring &bitstring::operator=(bitstring &&other) noexcept
+{
+    if (this == &other) return *this;
+    if (other.chunks == other.inline_chunks) return *this = other;
+
+    this->release();
+    this->size = other.size;
+    this->num_chunks = other.num_chunks;
     this->chunks = other.chunks;
 
+    // Leave the other empty
+    other.chunks = other.inline_chunks;
+    other.size = 0;
+    other.num_chunks = 0;
+
     return *this;
 }
 
@@ -226,6 +350,13 @@ bitstring bitstring::operator+(const bitstring &other)
     // Create a new bitstring for the result
     bitstring result(this->size + other.size);
 
+    // Word-level path
+    if (result.size <= 64)
+    {
+        result.set_uint64((this->get_uint64() << other.size) | other.get_uint64());
+        return result;
+    }
+
     // Copy the first bitstring
     for (int i = 0; i < this->size; i++)
     {
@@ -278,20 +409,36 @@ int bitstring::hamming_weight() const
 
 // Apply placement on the bitstring
 bitstring bitstring::place(placement &p)
+{
+    // Create a new bitstring for the result
+    bitstring result(p.get_output_size());
+    this->place_into(p, result);
+
+    return result;
+}
+
+// Apply placement on the bitstring into out
+void bitstring::place_into(placement &p, bitstring &out) const
 {
     // Output size
     int output_size = p.get_output_size();
 
     // Check if the placement is valid
     // assert(p.get_input_size() == this->size);
+    assert(out.size == output_size);
 
-    // Create a new bitstring for the result
-    bitstring result(output_size);
+    // Compiled kernel
+    if (p.is_compiled() && p.get_input_size() == this->size)
+    {
+        out.set_uint64(p.place_word(this->get_uint64()));
+        return;
+    }
 
     // Apply placement
-    for (int i = 0; i < output_size; i++) result.set_bit(i, this->get_bit(p.get_placement_table()[i]));
+    const std::vector<int> &table = p.get_placement_table();
+    for (int i = 0; i < output_size; i++) out.set_bit(i, this->get_bit(table[i]));
 
-    return result;
+    return;
 }
 
 // Apply inverse placement on the bitstring
@@ -306,8 +453,16 @@ bitstring bitstring::inv_place(placement &p)
     // Create a new bitstring for the result
     bitstring result(output_size);
 
+    // Compiled kernel
+    if (p.is_compiled() && p.is_invertible())
+    {
+        result.set_uint64(p.inv_place_word(this->get_uint64()));
+        return result;
+    }
+
     // Apply inverse placement
-    for (int i = 0; i < output_size; i++) result.set_bit(i, this->get_bit(p.get_inverse_table()[i]));
+    const std::vector<int> &table = p.get_inverse_table();
+    for (int i = 0; i < output_size; i++) result.set_bit(i, this->get_bit(table[i]));
 
     return result;
 }
@@ -323,12 +478,20 @@ bitstring bitstring::pseudo_inv_place(placement &p)
 
     // Create a shallow copy of the bitstring
     bitstring result = bitstring(output_size);
+
+    // Compiled kernel
+    if (p.is_compiled())
+    {
+        result.set_uint64(p.pseudo_inv_place_word(this->get_uint64()));
+        return result;
+    }
     
     // Iterate over the placement table
+    const std::vector<int> &table = p.get_placement_table();
     for (int i = 0; i < p.get_output_size(); i++)
     {
-        int index = p.get_placement_table()[i];
-        result.set_bit(p.get_placement_table()[i], result.get_bit(index) | this->get_bit(i));
+        int index = table[i];
+        result.set_bit(table[i], result.get_bit(index) | this->get_bit(i));
     }
 
     return result;
@@ -7,11 +7,24 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdint>
 
 // Custom Library Imports
 #include "placement.h"
 
-#define CHUNK_SIZE sizeof(int) * 8 // Size of each chunk in bits
+#define CHUNK_SIZE (sizeof(int) * 8) // Size of each chunk in bits
+#define INLINE_BITS 256              // Bits stored inline (larger sizes go to the heap)
+#define INLINE_CHUNKS (INLINE_BITS / CHUNK_SIZE)
+
+/*
+ * Storage:
+ * Chunks of up to INLINE_BITS bits live in the object itself, so
+ * blocks, halves, round keys and masks of the ciphers here never touch
+ * the heap; larger bitstrings spill to a heap buffer. chunks points at
+ * whichever holds them. Moves steal the heap buffer (or copy the inline
+ * chunks), and the *_into / *_inplace variants write into an existing
+ * bitstring instead of returning a new one.
+ */
 
 // Class def
 class bitstring
@@ -19,22 +32,27 @@ class bitstring
   public:
     // Member variables
     int size;                   // Size of the bitstring
-    std::vector<int> chunks;    // Chunks of the bitstring
+    int *chunks;                // Chunks of the bitstring (inline or heap)
     int num_chunks;             // Number of chunks
 
     // Constructors & Destructors
     bitstring(int size);
+    bitstring(const bitstring &other);              // Copy
+    bitstring(bitstring &&other) noexcept;          // Move
     ~bitstring();
 
     // Setters
     void set_bit(int index, int value);             // Set bit in big-endian
     void set_slice(int start, int end, int value);  // Set slice in big-endian
+    void set_uint64(uint64_t value);                // Set from packed word (size <= 64)
 
     // Getters
     int get_size() const { return this->size; }                 // Get size
     int get_bit(int index) const;                               // Get bit in big-endian
     bitstring get_slice(int start, int end) const;              // Get slice in big-endian
+    void slice_into(int start, int end, bitstring &out) const;  // Get slice into out (size end-start)
     int get_slice_int(int start, int end) const;                // Get small slice in big-endian (int)
+    uint64_t get_uint64() const;                                // Get as packed word (size <= 64)
     
     // Get/print in string format
     std::string get_string();                       // Get string in big-endian
@@ -45,8 +63,12 @@ class bitstring
     bitstring operator|(const bitstring &other);     // Bitwise OR
     bitstring operator^(const bitstring &other);     // Bitwise XOR
 
+    // In-place bitwise operations
+    void xor_inplace(const bitstring &other);        // Bitwise XOR into this
+
     // Assignment overload
-    bitstring &operator=(const bitstring &other);    // Assignment    
+    bitstring &operator=(const bitstring &other);    // Assignment
+    bitstring &operator=(bitstring &&other) noexcept; // Move assignment
 
     // Concatenation overload
     bitstring operator+(const bitstring &other);     // Concatenation
@@ -59,8 +81,15 @@ class bitstring
 
     // Apply placement on the bitstring
     bitstring place(placement &p); // Apply placement on the bitstring
+    void place_into(placement &p, bitstring &out) const; // Apply placement into out (output size)
     bitstring inv_place(placement &p); // Apply inverse placement on the bitstring
     bitstring pseudo_inv_place(placement &p); // Apply pseudo-inverse placement on the bitstring
+
+  private:
+    int inline_chunks[INLINE_CHUNKS]; // Inline storage (size <= INLINE_BITS)
+
+    void allocate(int size);          // Point chunks at storage for size bits (zeroed)
+    void release();                   // Free the heap storage, if any
 };
    
 #endif
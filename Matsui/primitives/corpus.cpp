@@ -0,0 +1,173 @@
+// Implementation of the corpus files
+#include "corpus.h"
+
+// Include Libraries
+#include <vector>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Custom Library Imports
+#include "prng.h"
+#include "work_pool.h"
+#include "attack.h"
+
+// Id of a keyed cipher over the given number of rounds
+uint64_t corpus_cipher_id(feistel &cipher, int rounds)
+{
+    // Encrypt a few fixed plaintexts
+    int block_size = cipher.get_block_size();
+    uint64_t mask = (block_size == 64) ? ~0ULL : ((1ULL << block_size) - 1);
+    uint64_t blocks[4];
+    uint64_t state = 0;
+    for (int i = 0; i < 4; i++) blocks[i] = splitmix64(state) & mask;
+    cipher.encrypt_batch(blocks, 4, rounds);
+
+    // Hash the ciphertexts with the block size and rounds
+    uint64_t id = ((uint64_t)block_size << 32) ^ (uint64_t)rounds;
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t mix = id ^ blocks[i];
+        id = splitmix64(mix);
+    }
+    return id;
+}
+
+// Write a corpus of count pairs
+bool corpus_generate(const std::string &path, feistel &cipher, int rounds,
+                     uint64_t count, uint64_t seed, int threads)
+{
+    // Check if the parameters are valid
+    int block_size = cipher.get_block_size();
+    assert(block_size <= 64 && rounds > 0 && rounds <= cipher.get_max_rounds());
+
+    // Header
+    corpus_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CORPUS_MAGIC, sizeof(header.magic));
+    header.version = CORPUS_VERSION;
+    header.block_size = block_size;
+    header.cipher_id = corpus_cipher_id(cipher, rounds);
+    header.rounds = rounds;
+    header.count = count;
+    header.seed = seed;
+
+    // Create and map the file
+    size_t length = sizeof(corpus_header) + 2 * count * sizeof(uint64_t);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, length) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+    std::memcpy(base, &header, sizeof(header));
+    uint64_t *plaintexts = (uint64_t *)((char *)base + sizeof(corpus_header));
+    uint64_t *ciphertexts = plaintexts + count;
+
+    // Generate and encrypt the chunks in place
+    work_pool workers(threads);
+    size_t chunks = (count + BATCH_SIZE - 1) / BATCH_SIZE;
+    workers.run(chunks, [&](int worker, size_t chunk)
+    {
+        uint64_t begin = chunk * BATCH_SIZE;
+        size_t batch = std::min<uint64_t>(BATCH_SIZE, count - begin);
+        random_blocks(seed, chunk, plaintexts + begin, batch, block_size);
+        std::copy(plaintexts + begin, plaintexts + begin + batch, ciphertexts + begin);
+        cipher.encrypt_batch(ciphertexts + begin, batch, rounds);
+    });
+
+    // Flush
+    bool ok = (msync(base, length, MS_SYNC) == 0);
+    munmap(base, length);
+    ::close(fd);
+    return ok;
+}
+
+// Constructors and Destructors
+corpus::corpus()
+{
+    this->fd = -1;
+    this->base = nullptr;
+    this->length = 0;
+    std::memset(&this->header, 0, sizeof(this->header));
+    this->plaintexts = nullptr;
+    this->ciphertexts = nullptr;
+}
+
+corpus::~corpus()
+{
+    this->close();
+}
+
+// Open and check a corpus file
+bool corpus::open(const std::string &path)
+{
+    this->close();
+
+    // Map the whole file
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(corpus_header))
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t length = info.st_size;
+    void *base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Check the header against the file
+    corpus_header header;
+    std::memcpy(&header, base, sizeof(header));
+    bool valid = std::memcmp(header.magic, CORPUS_MAGIC, sizeof(header.magic)) == 0
+                 && header.version == CORPUS_VERSION
+                 && header.block_size > 0 && header.block_size <= 64
+                 && header.count <= (length - sizeof(corpus_header)) / (2 * sizeof(uint64_t))
+                 && length == sizeof(corpus_header) + 2 * header.count * sizeof(uint64_t);
+    if (!valid)
+    {
+        munmap(base, length);
+        ::close(fd);
+        return false;
+    }
+
+    // Attacks read the arrays front to back
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    // Populate
+    this->fd = fd;
+    this->base = base;
+    this->length = length;
+    this->header = header;
+    this->plaintexts = (const uint64_t *)((const char *)base + sizeof(corpus_header));
+    this->ciphertexts = this->plaintexts + header.count;
+    return true;
+}
+
+// Unmap the file
+void corpus::close()
+{
+    if (this->base) munmap(this->base, this->length);
+    if (this->fd >= 0) ::close(this->fd);
+    this->fd = -1;
+    this->base = nullptr;
+    this->length = 0;
+    this->plaintexts = nullptr;
+    this->ciphertexts = nullptr;
+}
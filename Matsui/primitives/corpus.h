@@ -0,0 +1,96 @@
+// Known-plaintext corpus files for the Matsui attacks
+
+/*
+ * Format (native byte order):
+ *     header   64 bytes (see corpus_header)
+ *     P[0 .. count - 1]   plaintexts as packed words
+ *     C[0 .. count - 1]   ciphertexts as packed words
+ * Packed words hold a block in big-endian bit order, as everywhere
+ * else. Keeping the plaintexts and ciphertexts in two arrays lets
+ * the attacks read any range of pairs straight from the mapping.
+ */
+
+/*
+ * Cipher id:
+ * The id is a hash of a few fixed plaintexts encrypted by the keyed
+ * cipher over the corpus rounds, so a corpus only matches the cipher,
+ * key and rounds it was made with.
+ */
+
+/*
+ * Generation:
+ * Pairs are drawn exactly as matsui::collect does it (chunk c of
+ * BATCH_SIZE plaintexts from the stream (seed, c)), so an attack on
+ * a corpus made with seed s returns what it returns on generated data
+ * with seed s. Chunks are encrypted in parallel on a work pool.
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+// Standard Library Imports
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Custom Library Imports
+#include "feistel.h"
+
+// Magic and version of the format
+#define CORPUS_MAGIC "MATSUIKP"
+#define CORPUS_VERSION 1
+
+// Header of a corpus file
+struct corpus_header
+{
+  char magic[8];                    // CORPUS_MAGIC
+  uint32_t version;                 // CORPUS_VERSION
+  uint32_t block_size;              // Block size (<= 64)
+  uint64_t cipher_id;               // Id of the keyed cipher and rounds
+  uint64_t rounds;                  // Rounds of the encryption
+  uint64_t count;                   // Number of pairs
+  uint64_t seed;                    // Seed of the plaintexts
+  uint64_t reserved[2];
+};
+
+// Id of a keyed cipher over the given number of rounds
+uint64_t corpus_cipher_id(feistel &cipher, int rounds);
+
+// Write a corpus of count pairs (false if the file cannot be written)
+bool corpus_generate(const std::string &path, feistel &cipher, int rounds,
+                     uint64_t count, uint64_t seed, int threads);
+
+// Read-only memory mapping of a corpus file
+class corpus
+{
+  private:
+    int fd;                                     // File descriptor (-1 if closed)
+    void *base;                                 // Mapping of the file
+    size_t length;                              // Length of the mapping
+    corpus_header header;                       // Copy of the header
+    const uint64_t *plaintexts;                 // Plaintext array
+    const uint64_t *ciphertexts;                // Ciphertext array
+
+  public:
+    // Constructors & Destructors
+    corpus();
+    corpus(const corpus &) = delete;
+    corpus &operator=(const corpus &) = delete;
+    ~corpus();
+
+    // Open and check a corpus file (false if missing or malformed)
+    bool open(const std::string &path);
+    void close();
+
+    // Accessors
+    bool is_open() const { return this->base != nullptr; }
+    int get_block_size() const { return this->header.block_size; }
+    uint64_t get_cipher_id() const { return this->header.cipher_id; }
+    int get_rounds() const { return this->header.rounds; }
+    uint64_t get_count() const { return this->header.count; }
+    uint64_t get_seed() const { return this->header.seed; }
+    const uint64_t *get_plaintexts() const { return this->plaintexts; }
+    const uint64_t *get_ciphertexts() const { return this->ciphertexts; }
+};
+
+#endif
@@ -0,0 +1,22 @@
+// DES as a Feistel network (preset for tools and experiments)
+
+/*
+ * The tables are the FIPS 46-3 ones, written in the conventions of
+ * the feistel class (0-indexed, big-endian bit order). The key
+ * schedule is derived from PC-1, the rotations and PC-2: it lists, per
+ * round, the master key bit of each round key bit, so the 64-bit key
+ * includes the (unused) parity bits. Known answer: key
+ * 0x133457799BBCDFF1 encrypts 0x0123456789ABCDEF to 0x85E813540F0AB405.
+ */
+
+#ifndef DES_H
+#define DES_H
+
+// Custom Library Imports
+#include "bitstring.h"
+#include "feistel.h"
+
+// DES with 16 rounds and the given 64-bit key
+feistel des_cipher(bitstring key);
+
+#endif
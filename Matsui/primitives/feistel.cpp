@@ -5,65 +5,13 @@
 #include <iostream>
 #include <vector>
 #include <tuple>
+#include <cstdlib>
 #include <cassert>
 #include <cmath>
 #include <algorithm>
 #include <random>
 #include <iterator>
 
-#define DECAY 0.2
-
-// Helper (to eval bias aover a vector)
-float eval_bias(std::vector<float> bias, int lim)
-{
-    // Check if the vector is valid
-    assert(bias.size() > 0);
-
-    // Initialize bias
-    float res = 0.5;
-    for (int i = 0; i < lim; i++)
-    {
-        // Update bias
-        res *= 2*bias[i];
-    }
-    
-    // Absolute value
-    if (res < 0) res = -res;
-
-    // Return bias
-    return res;
-}
-
-// Print state
-void print_state(trail_state state)
-{
-    // Print the state
-    std::cout << "\033[31mCurrent Round: " << state.pres_round << std::endl;
-    std::cout << "Current S-Box: " << state.pres_sbox << std::endl;
-    std::cout << "Dummy: " << state.dummy << std::endl;
-
-    // Print roundwise info
-    for (int i = 0; i < state.total_rounds; i++)
-    {
-        std::cout << "Round " << i + 1 << ": ";
-        state.input_masks[i].print();
-        state.output_masks[i].print();
-        state.key_masks[i].print();
-        std::cout << "Bias: " << state.round_biases[i] << std::endl;
-    }
-
-    // Print current round info
-    for (int i = 0; i < state.total_sboxes; i++)
-    {
-        std::cout << "S-Box " << i + 1 << ": ";
-        std::cout << "Alpha: " << state.alphas[i] << ", Beta: " 
-                  << state.betas[i] << ", Bias: "
-                  << state.s_box_biases[i] << std::endl;
-    }
-
-    std::cout << "\033[0m" << std::endl;
-}
-
 // Constructors and Destructors
 feistel::feistel(int block_size, int max_rounds, std::vector<int> ip,
                  std::vector<int> fp, int num_sboxes, int sbox_in,
@@ -108,6 +56,21 @@ feistel::feistel(int block_size, int max_rounds, std::vector<int> ip,
     this->post_sbox = placement(block_size/2, block_size/2, post_sbox);
     this->key_size = key_size;
     this->key_schedule = key_schedule;
+    for (int i = 0; i < max_rounds; i++)
+    {
+        this->key_places.push_back(placement(key_size, key_schedule[i].size(), key_schedule[i]));
+    }
+
+    // Bitsliced engine built from the same primitives
+    this->sliced = bitslice(block_size, max_rounds, this->ip, this->fp, sboxes,
+                            this->prev_sbox, this->post_sbox, key_size, key_schedule);
+
+    // SP tables for the word-level round function
+    this->gen_tables();
+    this->table_mode = this->tables_valid;
+
+    // Expand round keys
+    this->set_key(master_key);
 }
 
 feistel::~feistel()
@@ -115,6 +78,80 @@ feistel::~feistel()
     // Destructor Logic
 }
 
+// Set master key and expand round keys
+void feistel::set_key(bitstring master_key)
+{
+    // Check if the key is valid
+    assert(master_key.get_size() == this->key_size);
+
+    // Populate
+    this->key = master_key;
+    this->round_keys.clear();
+    for (int i = 0; i < this->max_rounds; i++)
+    {
+        this->round_keys.push_back(master_key.place(this->key_places[i]));
+    }
+
+    // Packed round keys (table mode)
+    this->round_key_words.clear();
+    if (this->tables_valid)
+    {
+        for (int i = 0; i < this->max_rounds; i++) this->round_key_words.push_back(this->round_keys[i].get_uint64());
+    }
+
+    // Bitsliced round keys
+    this->sliced.set_key(master_key);
+}
+
+// Generate expansion and SP tables
+void feistel::gen_tables()
+{
+    // Both halves and the S-Box layer must fit in packed words
+    int half = this->block_size/2;
+    int layer = this->sbox_in*this->num_sboxes;
+    this->tables_valid = (half <= 64) && (layer <= 64) && this->prev_sbox.is_compiled();
+    if (!this->tables_valid) return;
+
+    // SP: S-Box output placed at its position and passed through post-S-Box
+    std::vector<int> post_table = this->post_sbox.get_placement_table();
+    this->sp_tables.assign(this->num_sboxes, std::vector<uint64_t>(1 << this->sbox_in, 0));
+    for (int i = 0; i < this->num_sboxes; i++)
+    {
+        for (int x = 0; x < (1 << this->sbox_in); x++)
+        {
+            int y = this->sboxes[i].eval(x);
+            for (int p = 0; p < half; p++)
+            {
+                // Output bit p reads S-Box layer bit post_table[p]
+                int pos = post_table[p] - i*this->sbox_out;
+                if (pos >= 0 && pos < this->sbox_out && ((y >> (this->sbox_out - 1 - pos)) & 1)) this->sp_tables[i][x] |= 1ULL << (half - 1 - p);
+            }
+        }
+    }
+}
+
+// Apply Round Function on packed words (eight lookups for DES)
+uint64_t feistel::round_function_word(uint64_t input, uint64_t round_key) const
+{
+    int layer = this->sbox_in*this->num_sboxes;
+
+    // Expansion layer (compiled placement)
+    uint64_t expanded = this->prev_sbox.place_word(input);
+
+    // Key mixing layer
+    uint64_t mixed = expanded ^ round_key;
+
+    // S-Box and post-S-Box layers
+    uint64_t output = 0;
+    uint64_t in_mask = (1ULL << this->sbox_in) - 1;
+    for (int i = 0; i < this->num_sboxes; i++)
+    {
+        output ^= this->sp_tables[i][(mixed >> (layer - (i + 1)*this->sbox_in)) & in_mask];
+    }
+
+    return output;
+}
+
 // Apply Round Function (Y = F(X, K))
 bitstring feistel::round_function(bitstring input, bitstring round_key)
 {
@@ -122,11 +159,20 @@ bitstring feistel::round_function(bitstring input, bitstring round_key)
     assert(input.get_size() == this->block_size/2);
     assert(round_key.get_size() == this->sbox_in*this->num_sboxes);
 
+    // Table-driven path
+    if (this->table_mode)
+    {
+        bitstring output(this->block_size/2);
+        output.set_uint64(this->round_function_word(input.get_uint64(), round_key.get_uint64()));
+        return output;
+    }
+
     // Apply expansion layer
-    bitstring expanded_input = input.place(this->prev_sbox);
+    bitstring mixed_input(round_key.get_size());
+    input.place_into(this->prev_sbox, mixed_input);
 
     // Key mixing layer
-    bitstring mixed_input = expanded_input ^ round_key;
+    mixed_input.xor_inplace(round_key);
 
     // Apply S-Box layer
     bitstring sbox_output = bitstring(round_key.get_size());
@@ -146,6 +192,98 @@ bitstring feistel::round_function(bitstring input, bitstring round_key)
     return post_sbox_output;
 } 
 
+// Encrypt a packed word (table mode)
+uint64_t feistel::encrypt_word(uint64_t plaintext, int rounds) const
+{
+    return this->encrypt_word(plaintext, this->round_key_words.data(), rounds);
+}
+
+// Expand a packed master key into packed round keys (first rounds only)
+void feistel::expand_key_word(uint64_t master_key, uint64_t *round_key_words, int rounds) const
+{
+    // Check if the key fits a packed word
+    assert(this->tables_valid && this->key_size <= 64);
+    assert(rounds <= this->max_rounds);
+
+    for (int i = 0; i < rounds; i++) round_key_words[i] = this->key_places[i].place_word(master_key);
+}
+
+// Encrypt one plaintext under many packed master keys
+void feistel::encrypt_keys(uint64_t plaintext, const uint64_t *master_keys, uint64_t *ciphertexts, size_t count, int rounds) const
+{
+    // Key-sliced fast path (SLICE_LANES keys per pass)
+    if (this->sliced.is_supported() && this->key_size <= 64)
+    {
+        slice_t key_slices[64], state[64];
+        for (size_t base = 0; base < count; base += SLICE_LANES)
+        {
+            size_t n = std::min((size_t)SLICE_LANES, count - base);
+            pack_slices(master_keys + base, n, this->key_size, key_slices);
+            this->sliced.encrypt_keys(plaintext, key_slices, state, rounds);
+            unpack_slices(state, this->block_size, ciphertexts + base, n);
+        }
+        return;
+    }
+
+    // Fallback (one key at a time, table mode)
+    std::vector<uint64_t> round_key_words(rounds);
+    for (size_t i = 0; i < count; i++)
+    {
+        this->expand_key_word(master_keys[i], round_key_words.data(), rounds);
+        ciphertexts[i] = this->encrypt_word(plaintext, round_key_words.data(), rounds);
+    }
+}
+
+// Encrypt a packed word under packed round keys (table mode)
+uint64_t feistel::encrypt_word(uint64_t plaintext, const uint64_t *round_key_words, int rounds) const
+{
+    // Check if the word-level path is available
+    assert(this->tables_valid && this->block_size <= 64);
+    assert(rounds <= this->max_rounds);
+
+    // Apply initial permutation and split into two halves
+    int half = this->block_size/2;
+    uint64_t half_mask = (1ULL << half) - 1;
+    uint64_t permuted_input = this->ip.place_word(plaintext);
+    uint64_t left_half = permuted_input >> half;
+    uint64_t right_half = permuted_input & half_mask;
+
+    // Apply rounds
+    for (int i = 0; i < rounds; i++)
+    {
+        left_half ^= this->round_function_word(right_half, round_key_words[i]);
+        if (i < rounds - 1) std::swap(left_half, right_half);
+    }
+
+    // Combine halves and apply final permutation
+    return this->fp.place_word((left_half << half) | right_half);
+}
+
+// Decrypt a packed word (table mode)
+uint64_t feistel::decrypt_word(uint64_t ciphertext, int rounds) const
+{
+    // Check if the word-level path is available
+    assert(this->tables_valid && this->block_size <= 64);
+    assert(rounds <= this->max_rounds);
+
+    // Undo final permutation and split into two halves
+    int half = this->block_size/2;
+    uint64_t half_mask = (1ULL << half) - 1;
+    uint64_t permuted_input = this->fp.inv_place_word(ciphertext);
+    uint64_t left_half = permuted_input >> half;
+    uint64_t right_half = permuted_input & half_mask;
+
+    // Apply rounds in reverse order
+    for (int i = rounds - 1; i >= 0; i--)
+    {
+        left_half ^= this->round_function_word(right_half, this->round_key_words[i]);
+        if (i > 0) std::swap(left_half, right_half);
+    }
+
+    // Combine halves and undo initial permutation
+    return this->ip.inv_place_word((left_half << half) | right_half);
+}
+
 // Encrypt
 bitstring feistel::encrypt(bitstring plaintext, int rounds)
 {
@@ -154,32 +292,32 @@ bitstring feistel::encrypt(bitstring plaintext, int rounds)
     assert(key.get_size() == this->key_size);
     assert(rounds <= this->max_rounds);
 
+    // Word-level path
+    if (this->table_mode && this->block_size <= 64)
+    {
+        bitstring ciphertext(this->block_size);
+        ciphertext.set_uint64(this->encrypt_word(plaintext.get_uint64(), rounds));
+        return ciphertext;
+    }
+
     // Apply initial permutation
-    bitstring permuted_input = plaintext.place(this->ip);
+    bitstring permuted_input(this->block_size);
+    plaintext.place_into(this->ip, permuted_input);
 
     // Split into two halves
-    bitstring left_half = permuted_input.get_slice(0, this->block_size/2);
-    bitstring right_half = permuted_input.get_slice(this->block_size/2, this->block_size);
+    bitstring left_half(this->block_size/2), right_half(this->block_size/2);
+    permuted_input.slice_into(0, this->block_size/2, left_half);
+    permuted_input.slice_into(this->block_size/2, this->block_size, right_half);
 
     // Apply rounds
     for (int i = 0; i < rounds; i++)
     {
-        // Get round key placement
-        placement temp_place = placement(this->key_size, this->key_schedule[i].size(), this->key_schedule[i]);
-        // Get round key
-        bitstring round_key = key.place(temp_place);
-        
-        // Apply round function
-        bitstring round_output = round_function(right_half, round_key);
+        // Apply round function (cached round key)
+        bitstring round_output = round_function(right_half, this->round_keys[i]);
         // Apply XOR
-        left_half = left_half ^ round_output;
+        left_half.xor_inplace(round_output);
         // Swap halves
-        if (i < rounds - 1)
-        {
-          bitstring temp = left_half;
-          left_half = right_half;
-          right_half = temp; 
-        }
+        if (i < rounds - 1) std::swap(left_half, right_half);
     }
 
     // Combine halves
@@ -199,6 +337,14 @@ bitstring feistel::decrypt(bitstring ciphertext, int rounds)
     assert(key.get_size() == this->key_size);
     assert(rounds <= this->max_rounds);
 
+    // Word-level path
+    if (this->table_mode && this->block_size <= 64)
+    {
+        bitstring plaintext(this->block_size);
+        plaintext.set_uint64(this->decrypt_word(ciphertext.get_uint64(), rounds));
+        return plaintext;
+    }
+
     // Apply initial permutation
     bitstring permuted_input = ciphertext.inv_place(this->fp);
 
@@ -209,13 +355,8 @@ bitstring feistel::decrypt(bitstring ciphertext, int rounds)
     // Apply rounds in reverse order
     for (int i = rounds - 1; i >= 0; i--)
     {
-        // Get round key placement
-        placement temp_place = placement(this->key_size, this->key_schedule[i].size(), this->key_schedule[i]);
-        // Get round key
-        bitstring round_key = key.place(temp_place);
-        
-        // Apply round function
-        bitstring round_output = round_function(right_half, round_key);
+        // Apply round function (cached round key)
+        bitstring round_output = round_function(right_half, this->round_keys[i]);
         // Apply XOR
         left_half = left_half ^ round_output;
         // Swap halves
@@ -236,412 +377,138 @@ bitstring feistel::decrypt(bitstring ciphertext, int rounds)
     return plaintext;
 }
 
-// Round Approximations
-std::tuple<bitstring, bitstring, bitstring> feistel::round_approx(int s_box_num, 
-                                                     int input_mask,
-                                                     int output_mask)
+// Batch Encrypt (packed blocks, in place)
+void feistel::encrypt_batch(uint64_t *blocks, size_t count, int rounds)
 {
-    // Check if the S-Box number is valid
-    assert(s_box_num >= 0 && s_box_num < this->num_sboxes);
-
-    // Get the S-Box
-    s_box sbox = this->sboxes[s_box_num];
-
-    // Apply the input mask (apply, pseudo-inverse, and apply)
-    bitstring slayer_input = bitstring(this->sbox_in * this->num_sboxes);
-    slayer_input.set_slice(s_box_num * this->sbox_in, (s_box_num + 1) * this->sbox_in, input_mask);
-    bitstring main_input = slayer_input.pseudo_inv_place(this->prev_sbox);
-  
-    // Iterate over S-Boxes and decide output masks
-    bitstring slayer_output = bitstring(this->sbox_out * this->num_sboxes);
-    slayer_output.set_slice(s_box_num * this->sbox_out, (s_box_num + 1) * this->sbox_out, output_mask);
-
-    // Get the output mask
-    bitstring main_output = slayer_output.place(this->post_sbox);
-
-    // Return
-    return std::make_tuple(main_input, slayer_input, main_output);
-}
+    // Check if the parameters are valid
+    assert(this->block_size <= 64);
+    assert(rounds <= this->max_rounds);
 
-// Find lin trail
-trail_state feistel::find_linear_trail(trail_state state, int rounds, bool start)
-{
-    // If start, initialize the state
-    if (start)
+    // Bitsliced fast path
+    if (this->sliced.is_supported())
     {
-        // Net Info
-        state.total_rounds = rounds;
-        state.total_sboxes = this->num_sboxes;
-        state.pres_round = 0;
-        state.pres_sbox = 0;
-        state.dummy = true;
-
-        // Roundwise Info
-        for (int i = 0; i < rounds; i++)
-        {
-            // Input Masks
-            state.input_masks.push_back(bitstring(this->block_size/2));
-            // Output Masks
-            state.output_masks.push_back(bitstring(this->block_size/2));
-            // Key Masks
-            state.key_masks.push_back(bitstring(this->sbox_in*this->num_sboxes));
-            // Round Biases
-            state.round_biases.push_back(0.0);
-        }
-
-        // Current Round Info
-        for (int i = 0; i < this->num_sboxes; i++)
-        {
-            // Alphas
-            state.alphas.push_back(0);
-            // Betas
-            state.betas.push_back(0);
-            // S-Box Biases
-            state.s_box_biases.push_back(0.0);
-        }
+        this->sliced.encrypt(blocks, blocks, count, rounds);
+        return;
     }
 
-    // When pres_round = 0
-    if (state.pres_round == 0)
+    // Fallback (one block at a time)
+    bitstring block(this->block_size);
+    for (size_t i = 0; i < count; i++)
     {
-        // For every candidate of round-output-mask, find the best candidate for round-input-mask
-        // For the first round, we can safely assume we only work with one active S-Box at a time
-        // Ignore 0-output-masks
-        
-        // Keep track of possible new bias
-        std::vector<float> new_biases = state.round_biases;
-
-        for (int i = 0; i < this->num_sboxes; i++)
-        {
-            // Get the S-Box
-            s_box sbox = this->sboxes[i];
-
-            // Iterate over output masks
-            for (int j = 1; j < (1 << this->sbox_out); j++)
-            {
-                // Get the output mask
-                int output_mask = j;
-
-                // Best possible lat-entry for output mask
-                lat_entry best_entry = sbox.get_lat_top_out(output_mask);
-
-                // Update the new biases
-                new_biases[0] = (best_entry.bias)/(1 << this->sbox_in);
-
-                // If evaluated bias is better than current, update
-                if (state.dummy || eval_bias(new_biases, rounds) >= eval_bias(state.round_biases, rounds))
-                {
-                    // Expand s-box masks into round approximations 
-                    int input_mask = best_entry.a;
-                    std::tuple<bitstring, bitstring, bitstring> approx = round_approx(i, input_mask, output_mask);
-                    // Update the state
-                    state.input_masks[0] = std::get<0>(approx);
-                    state.key_masks[0] = std::get<1>(approx);
-                    state.output_masks[0] = std::get<2>(approx);
-                    state.round_biases[0] = new_biases[0];
-                    std::cout << "SBOX " << i << std::endl;
-                    print_state(state);
-                    std::cout << std::endl;
-                    // Call the function again
-                    if (state.total_rounds > 1)
-                    {
-                        state.pres_round = 1;
-                        state = find_linear_trail(state, rounds, false);
-                        new_biases = state.round_biases;
-                    }
-                    else
-                    {
-                        // End of recursion
-                        if (state.dummy) state.dummy = false;
-                    }
-                }
-            }
-        }
+        block.set_uint64(blocks[i]);
+        blocks[i] = this->encrypt(block, rounds).get_uint64();
     }
+}
 
-    // When pres_round = 1
-    else if (state.pres_round == 1)
-    {
-        // We iterate over all input-mask and output-mask pairs for each S-Box
-        // Again, for this round, we only work with one active S-Box at a time
-
-        // Keep track of possible new bias
-        std::vector<float> new_biases = state.round_biases;
-
-        // Iterate over S-Boxes
-        for (int i = 0; i < this->num_sboxes; i++)
-        {
-            // Get the S-Box
-            s_box sbox = this->sboxes[i];
-
-            // Get lat_entries (automatically sorted)
-            std::vector<lat_entry> lat_entries = sbox.get_lat();
+// Batch Decrypt (packed blocks, in place)
+void feistel::decrypt_batch(uint64_t *blocks, size_t count, int rounds)
+{
+    // Check if the parameters are valid
+    assert(this->block_size <= 64);
+    assert(rounds <= this->max_rounds);
 
-            // Iterate over vector
-            for (int j = 0; j < lat_entries.size(); j++)
-            {
-                // Get the entry
-                lat_entry entry = lat_entries[j];
-
-                // Get the input and output masks
-                int input_mask = entry.a;
-                int output_mask = entry.b;
-
-                // Update the new biases
-                new_biases[1] = (entry.bias)/(1 << this->sbox_in);
-
-                // If evaluated bias is better than current, update
-                if (state.dummy || eval_bias(new_biases, rounds) >= eval_bias(state.round_biases, rounds))
-                {
-                    // Expand s-box masks into round approximations 
-                    std::tuple<bitstring, bitstring, bitstring> approx = round_approx(i, input_mask, output_mask);
-                    // Update the state
-                    state.input_masks[1] = std::get<0>(approx);
-                    state.key_masks[1] = std::get<1>(approx);
-                    state.output_masks[1] = std::get<2>(approx);
-                    state.round_biases[1] = new_biases[1];
-                    std::cout << "SBOX " << i << std::endl;
-                    print_state(state);
-                    std::cout << std::endl;
-                    // Call the function again
-                    if (state.total_rounds > 2)
-                    {
-                        state.pres_round = 2;
-                        state = find_linear_trail(state, rounds, false);
-                        new_biases = state.round_biases;
-                    }
-                    else
-                    {
-                        // End of recursion
-                        if (state.dummy) state.dummy = false;
-                    }
-                }
-            }
-        }
+    // Bitsliced fast path
+    if (this->sliced.is_supported())
+    {
+        this->sliced.decrypt(blocks, blocks, count, rounds);
+        return;
     }
 
-    // When pres_round lies in 2, 3... total_rounds-2
-    else if (state.pres_round < state.total_rounds - 1)
+    // Fallback (one block at a time)
+    bitstring block(this->block_size);
+    for (size_t i = 0; i < count; i++)
     {
-        // Get output mask (O[i] = O[i-2] + I[i-1])
-        bitstring output_mask = state.output_masks[state.pres_round - 2] ^ state.input_masks[state.pres_round - 1];
-        bitstring slayer_output = output_mask.inv_place(this->post_sbox);
-        
-        // We perform this but over all S-Boxes via recursion on pres_sbox. 
-        if (state.pres_sbox < this->num_sboxes - 1)
-        {
-            // If state.pres_sbox == 0
-            if (state.pres_sbox == 0)
-            {
-                // Set the all pres_rounds masks to all 0s
-                state.input_masks[state.pres_round] = bitstring(this->block_size/2);
-                state.key_masks[state.pres_round] = bitstring(this->sbox_in*this->num_sboxes);
-                state.output_masks[state.pres_round] = bitstring(this->block_size/2);
-            }
+        block.set_uint64(blocks[i]);
+        blocks[i] = this->decrypt(block, rounds).get_uint64();
+    }
+}
 
-            // Get the S-Box
-            s_box sbox = this->sboxes[state.pres_sbox];
+// Cross-check the bitsliced engine against encrypt/decrypt
+bool feistel::cross_check(int samples, int rounds)
+{
+    // Check if the engine is usable
+    assert(samples > 0);
+    assert(rounds <= this->max_rounds);
+    if (!this->sliced.is_supported()) return false;
 
-            // Get output mask
-            int op_mask = slayer_output.get_slice_int(state.pres_sbox*this->sbox_out, (state.pres_sbox + 1)*this->sbox_out);
-            // Get lat_entries just for this output mask
-            std::vector<lat_entry> lat_entries = sbox.get_lat_outs(op_mask);
+    // Random plaintexts
+    std::vector<uint64_t> plaintexts(samples);
+    for (int i = 0; i < samples; i++)
+    {
+        bitstring plaintext(this->block_size);
+        for (int j = 0; j < this->block_size; j++) plaintext.set_bit(j, rand() % 2);
+        plaintexts[i] = plaintext.get_uint64();
+    }
 
-            // Copy both biases
-            std::vector<float> new_round_biases = state.round_biases;
-            std::vector<float> new_sbox_biases = state.s_box_biases;
+    // Bitsliced encryption and decryption
+    std::vector<uint64_t> ciphertexts(samples);
+    std::vector<uint64_t> decrypted(samples);
+    this->sliced.encrypt(plaintexts.data(), ciphertexts.data(), samples, rounds);
+    this->sliced.decrypt(ciphertexts.data(), decrypted.data(), samples, rounds);
 
-            // Iterate over vector
-            for (int j = 0; j < lat_entries.size(); j++)
-            {
-                // Get the entry
-                lat_entry entry = lat_entries[j];
-
-                // Get the input and output masks
-                int input_mask = entry.a;
-                int output_mask = entry.b;
-
-                // Update new s_box biases
-                new_sbox_biases[state.pres_sbox] = (entry.bias)/(1 << this->sbox_in);
-                float total_sbox_bias = eval_bias(new_sbox_biases, state.pres_sbox + 1);
-                new_round_biases[state.pres_round] = total_sbox_bias;
-
-                // If evaluated bias is better than current, update
-                if (state.dummy || eval_bias(new_round_biases, rounds) >= eval_bias(state.round_biases, rounds))
-                {
-                    // Expand s-box masks into round approximations 
-                    std::tuple<bitstring, bitstring, bitstring> approx = round_approx(state.pres_sbox, input_mask, output_mask);
-                    // Update the state
-                    state.input_masks[state.pres_round] = state.input_masks[state.pres_round] | std::get<0>(approx);
-                    state.key_masks[state.pres_round] = state.key_masks[state.pres_round] | std::get<1>(approx);
-                    state.output_masks[state.pres_round] = state.output_masks[state.pres_round] | std::get<2>(approx);
-                    state.s_box_biases[state.pres_sbox] = new_sbox_biases[state.pres_sbox];
-                    print_state(state);
-                    // Call the function again
-                    state.pres_sbox++;
-                    state = find_linear_trail(state, rounds, false);
-                    new_sbox_biases = state.s_box_biases;
-                }
-            }
-        }
-        // Final S-Box
-        else
+    // Compare against the scalar implementation (table-driven and bit-level)
+    bool saved_mode = this->table_mode;
+    bool match = true;
+    for (int mode = 0; mode < 2 && match; mode++)
+    {
+        this->set_table_mode(mode == 0);
+        for (int i = 0; i < samples && match; i++)
         {
-            // Get the S-Box
-            s_box sbox = this->sboxes[state.pres_sbox];
-
-            // Get output mask
-            int op_mask = slayer_output.get_slice_int(state.pres_sbox*this->sbox_out, (state.pres_sbox + 1)*this->sbox_out);
-            // Get lat_entries just for this output mask
-            std::vector<lat_entry> lat_entries = sbox.get_lat_outs(op_mask);
-
-            // Copy both biases
-            std::vector<float> new_round_biases = state.round_biases;
-            std::vector<float> new_sbox_biases = state.s_box_biases;
-
-            // Iterate over vector
-            for (int j = 0; j < lat_entries.size(); j++)
-            {
-                // Get the entry
-                lat_entry entry = lat_entries[j];
-
-                // Get the input and output masks
-                int input_mask = entry.a;
-                int output_mask = entry.b;
-
-                // Update new s_box biases
-                new_sbox_biases[state.pres_sbox] = (entry.bias)/(1 << this->sbox_in);
-                float total_sbox_bias = eval_bias(new_sbox_biases, state.pres_sbox + 1);
-                new_round_biases[state.pres_round] = total_sbox_bias;
-
-                // If evaluated bias is better than current, update
-                if (state.dummy || eval_bias(new_round_biases, rounds) >= eval_bias(state.round_biases, rounds))
-                {
-                    // Expand s-box masks into round approximations 
-                    std::tuple<bitstring, bitstring, bitstring> approx = round_approx(state.pres_sbox, input_mask, output_mask);
-                    // Update the state
-                    state.input_masks[state.pres_round] = state.input_masks[state.pres_round] | std::get<0>(approx);
-                    state.key_masks[state.pres_round] = state.key_masks[state.pres_round] | std::get<1>(approx);
-                    state.output_masks[state.pres_round] = state.output_masks[state.pres_round] | std::get<2>(approx);
-                    state.s_box_biases[state.pres_sbox] = new_sbox_biases[state.pres_sbox];
-                    state.round_biases[state.pres_round] = new_round_biases[state.pres_round];
-                    print_state(state);
-                    // Call the function again
-                    state.pres_sbox = 0;
-                    state.pres_round += 1 + state.pres_sbox;
-                    state = find_linear_trail(state, rounds, false);
-                    print_state(state);
-                    new_sbox_biases = state.s_box_biases;
-                    new_round_biases = state.round_biases;
-                }
-            }
+            bitstring plaintext(this->block_size);
+            plaintext.set_uint64(plaintexts[i]);
+            bitstring ciphertext = this->encrypt(plaintext, rounds);
+            if (ciphertext.get_uint64() != ciphertexts[i]) match = false;
+            else if (this->decrypt(ciphertext, rounds).get_uint64() != decrypted[i]) match = false;
+            else if (decrypted[i] != plaintexts[i]) match = false;
         }
     }
-    
-    // Last Round
-    else
-    {
-        // Get output mask (O[i] = O[i-2] + I[i-1]) 
-        bitstring output_mask = state.output_masks[state.pres_round - 2] ^ state.input_masks[state.pres_round - 1];
-        bitstring slayer_output = output_mask.inv_place(this->post_sbox);
-        std::cout << "Output Mask: ";
-        output_mask.print();
-        std::cout << "Slayer Output: ";
-        slayer_output.print();
-
-        // We do the same as before, except just fetch the best possible input mask
-        if (state.pres_sbox < this->num_sboxes - 1)
-        {
-            // If state.pres_sbox == 0
-            if (state.pres_sbox == 0)
-            {
-                // Set the all pres_rounds masks to all 0s
-                state.input_masks[state.pres_round] = bitstring(this->block_size/2);
-                state.key_masks[state.pres_round] = bitstring(this->sbox_in*this->num_sboxes);
-                state.output_masks[state.pres_round] = bitstring(this->block_size/2);
-            }
+    this->table_mode = saved_mode;
 
-            // Get the S-Box
-            s_box sbox = this->sboxes[state.pres_sbox];
-
-            // Get output mask
-            int op_mask = slayer_output.get_slice_int(state.pres_sbox*this->sbox_out, (state.pres_sbox + 1)*this->sbox_out);
-            // Get best lat_entry for this output mask
-            lat_entry best_entry = sbox.get_lat_top_out(op_mask);
-
-            // Copy both biases
-            std::vector<float> new_round_biases = state.round_biases;
-            std::vector<float> new_sbox_biases = state.s_box_biases;
+    return match;
+}
 
-            // Evaluate biases
-            new_sbox_biases[state.pres_sbox] = (best_entry.bias)/(1 << this->sbox_in);
-            float total_sbox_bias = eval_bias(new_sbox_biases, state.pres_sbox + 1);
-            new_round_biases[state.pres_round] = total_sbox_bias;
+// Round Approximations
+std::tuple<bitstring, bitstring, bitstring> feistel::round_approx(int s_box_num, 
+                                                     int input_mask,
+                                                     int output_mask)
+{
+    // Check if the S-Box number is valid
+    assert(s_box_num >= 0 && s_box_num < this->num_sboxes);
 
-            // If evaluated bias is better than current, update
-            if (state.dummy || eval_bias(new_round_biases, rounds) >= eval_bias(state.round_biases, rounds))
-            {
-                // Expand s-box masks into round approximations 
-                int input_mask = best_entry.a;
-                std::tuple<bitstring, bitstring, bitstring> approx = round_approx(state.pres_sbox, input_mask, op_mask);
-                // Update the state
-                state.input_masks[state.pres_round] = state.input_masks[state.pres_round] | std::get<0>(approx);
-                state.key_masks[state.pres_round] = state.key_masks[state.pres_round] | std::get<1>(approx);
-                state.output_masks[state.pres_round] = state.output_masks[state.pres_round] | std::get<2>(approx);
-                state.s_box_biases[state.pres_sbox] = new_sbox_biases[state.pres_sbox];
-                print_state(state);
-                // Call the function again
-                state.pres_sbox++;
-                state = find_linear_trail(state, rounds, false);
-                new_sbox_biases = state.s_box_biases;
-            }
-        }
-        // If last s-box
-        else
-        {
-            // Get the S-Box
-            s_box sbox = this->sboxes[state.pres_sbox];
+    // Apply the input mask (apply, pseudo-inverse, and apply)
+    bitstring slayer_input = bitstring(this->sbox_in * this->num_sboxes);
+    slayer_input.set_slice(s_box_num * this->sbox_in, (s_box_num + 1) * this->sbox_in, input_mask);
+    bitstring main_input = slayer_input.pseudo_inv_place(this->prev_sbox);
+  
+    // Iterate over S-Boxes and decide output masks
+    bitstring slayer_output = bitstring(this->sbox_out * this->num_sboxes);
+    slayer_output.set_slice(s_box_num * this->sbox_out, (s_box_num + 1) * this->sbox_out, output_mask);
 
-            // Get output mask
-            int op_mask = slayer_output.get_slice_int(state.pres_sbox*this->sbox_out, (state.pres_sbox + 1)*this->sbox_out);
-            // Get best lat_entry for this output mask
-            lat_entry best_entry = sbox.get_lat_top_out(op_mask);
+    // Get the output mask
+    bitstring main_output = slayer_output.place(this->post_sbox);
 
-            // Copy both biases
-            std::vector<float> new_round_biases = state.round_biases;
-            std::vector<float> new_sbox_biases = state.s_box_biases;
+    // Return
+    return std::make_tuple(main_input, slayer_input, main_output);
+}
 
-            // Evaluate biases
-            new_sbox_biases[state.pres_sbox] = (best_entry.bias)/(1 << this->sbox_in);
-            float total_sbox_bias = eval_bias(new_sbox_biases, state.pres_sbox + 1);
-            new_round_biases[state.pres_round] = total_sbox_bias;
+// Find the best linear trail (Matsui's branch-and-bound search)
+trail_state feistel::find_linear_trail(int rounds)
+{
+    // Check if the number of rounds is valid
+    assert(rounds > 0 && rounds <= this->max_rounds);
 
-            // If evaluated bias is better than current, update
-            if (state.dummy || eval_bias(new_round_biases, rounds) >= eval_bias(state.round_biases, rounds))
-            {
-                // Expand s-box masks into round approximations 
-                int input_mask = best_entry.a;
-                std::tuple<bitstring, bitstring, bitstring> approx = round_approx(state.pres_sbox, input_mask, op_mask);
-                // Update the state
-                state.input_masks[state.pres_round] = state.input_masks[state.pres_round] | std::get<0>(approx);
-                state.key_masks[state.pres_round] = state.key_masks[state.pres_round] | std::get<1>(approx);
-                state.output_masks[state.pres_round] = state.output_masks[state.pres_round] | std::get<2>(approx);
-                state.s_box_biases[state.pres_sbox] = new_sbox_biases[state.pres_sbox];
-                state.round_biases[state.pres_round] = new_round_biases[state.pres_round];
-                print_state(state);
-                // End of recursion
-                state.pres_sbox = 0;
-                state.pres_round += state.total_sboxes;
-                if (state.dummy) state.dummy = false;
-                new_sbox_biases = state.s_box_biases;
-                new_round_biases = state.round_biases;
-            }
-        }
-    }
+    // Search
+    trail_search search(this->block_size, this->sboxes, this->prev_sbox, this->post_sbox);
+    return search.search(rounds);
+}
 
+// Find the best top_k linear trails (parallel search, 0 threads = all cores)
+std::vector<trail_state> feistel::find_linear_trails(int rounds, int top_k, int threads)
+{
+    // Check if the parameters are valid
+    assert(rounds > 0 && rounds <= this->max_rounds && top_k > 0);
 
-    // Return
-    state.pres_round--;
-    std::cout << "Going from " << state.pres_round + 1 << " to " << state.pres_round << std::endl;
-    return state;
+    // Search
+    trail_search search(this->block_size, this->sboxes, this->prev_sbox, this->post_sbox);
+    return search.search_top(rounds, top_k, threads);
 }
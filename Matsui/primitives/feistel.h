@@ -60,31 +60,9 @@
 #include "s_box.h"
 #include "placement.h"
 #include "bitstring.h"
-
-// Define DECAY constant
-#define DECAY 0.2
-
-// Struct to hold state for trail
-struct trail_state
-{
-  // Net Info
-  int total_rounds;
-  int total_sboxes;
-  int pres_round;
-  int pres_sbox;
-  bool dummy;
-
-  // Roundwise Info
-  std::vector<bitstring> input_masks;
-  std::vector<bitstring> output_masks;
-  std::vector<bitstring> key_masks;
-  std::vector<float> round_biases;
-
-  // Current Round Info
-  std::vector<int> alphas;
-  std::vector<int> betas;
-  std::vector<float> s_box_biases;
-};
+#include "fixed_bitstring.h"
+#include "bitslice.h"
+#include "trail_search.h"
 
 class feistel
 {
@@ -103,6 +81,16 @@ class feistel
     int key_size;                               // Key size
     std::vector<std::vector<int>> key_schedule; // Key schedule
     bitstring key;                     // Master key
+    std::vector<placement> key_places;          // Key schedule as placements
+    std::vector<bitstring> round_keys;          // Round keys (expanded from the master key)
+    std::vector<uint64_t> round_key_words;      // Round keys as packed words
+    bitslice sliced;                            // Bitsliced engine (same primitives)
+
+    // Table-driven round function (SP tables)
+    bool table_mode;                            // Use the tables in round_function
+    bool tables_valid;                          // Tables fit in packed words
+    std::vector<std::vector<uint64_t>> sp_tables;  // Permuted S-Box outputs [sbox][input]
+    void gen_tables();
 
   public:
     // Constructors & Destructors
@@ -125,10 +113,20 @@ class feistel
     int get_num_sboxes() { return this->num_sboxes; }
     int get_sbox_in() { return this->sbox_in; }
     int get_sbox_out() { return this->sbox_out; }
+    std::vector<s_box> get_sboxes() { return this->sboxes; }
     std::vector<std::vector<int>> get_key_schedule() { return this->key_schedule; }
+    const bitslice &get_bitslice() const { return this->sliced; }
+    bitstring get_key() { return this->key; }
+    bitstring get_round_key(int round) { return this->round_keys[round]; }
+
+    // Re-key (expands round keys once, no reconstruction needed)
+    void set_key(bitstring master_key);
 
     // Round primitives
     bitstring round_function(bitstring input, bitstring round_key); 
+    uint64_t round_function_word(uint64_t input, uint64_t round_key) const;
+    void set_table_mode(bool enable) { this->table_mode = enable && this->tables_valid; }
+    bool get_table_mode() { return this->table_mode; }
 
     // Encryption & Decryption
     bitstring encrypt(bitstring plaintext,
@@ -136,12 +134,57 @@ class feistel
     bitstring decrypt(bitstring ciphertext,
                               int rounds);
 
+    // Word-level Encryption & Decryption (table mode, block size <= 64)
+    uint64_t encrypt_word(uint64_t plaintext, int rounds) const;
+    uint64_t decrypt_word(uint64_t ciphertext, int rounds) const;
+
+    // Word-level primitives under other keys (key size <= 64, no re-keying)
+    void expand_key_word(uint64_t master_key, uint64_t *round_key_words, int rounds) const;
+    uint64_t encrypt_word(uint64_t plaintext, const uint64_t *round_key_words, int rounds) const;
+    // One plaintext under many master keys (key-sliced on the bitsliced engine)
+    void encrypt_keys(uint64_t plaintext, const uint64_t *master_keys, uint64_t *ciphertexts, size_t count, int rounds) const;
+
+    // Fixed-width (allocation-free) primitives
+    template <int N, int M>
+    fixed_bitstring<N> round_function(const fixed_bitstring<N> &input, const fixed_bitstring<M> &round_key) const
+    {
+        assert(N == this->block_size/2 && M == this->sbox_in*this->num_sboxes);
+        assert(this->tables_valid);
+        fixed_bitstring<N> output;
+        output.set_uint64(this->round_function_word(input.get_uint64(), round_key.get_uint64()));
+        return output;
+    }
+    template <int N>
+    fixed_bitstring<N> encrypt(const fixed_bitstring<N> &plaintext, int rounds) const
+    {
+        assert(N == this->block_size);
+        fixed_bitstring<N> ciphertext;
+        ciphertext.set_uint64(this->encrypt_word(plaintext.get_uint64(), rounds));
+        return ciphertext;
+    }
+    template <int N>
+    fixed_bitstring<N> decrypt(const fixed_bitstring<N> &ciphertext, int rounds) const
+    {
+        assert(N == this->block_size);
+        fixed_bitstring<N> plaintext;
+        plaintext.set_uint64(this->decrypt_word(ciphertext.get_uint64(), rounds));
+        return plaintext;
+    }
+
+    // Batch Encryption & Decryption (packed blocks, in place)
+    void encrypt_batch(uint64_t *blocks, size_t count, int rounds);
+    void decrypt_batch(uint64_t *blocks, size_t count, int rounds);
+
+    // Cross-check the bitsliced engine against encrypt/decrypt
+    bool cross_check(int samples, int rounds);
+
     // Finding Linear Trails
     std::tuple<bitstring, bitstring, bitstring> round_approx(int s_box_num, 
                                                          int input_mask,
                                                          int output_mask
                                                          );
-    trail_state find_linear_trail(trail_state state, int rounds, bool start);
+    trail_state find_linear_trail(int rounds);
+    std::vector<trail_state> find_linear_trails(int rounds, int top_k, int threads = 0);
 };
 
 #endif
@@ -0,0 +1,249 @@
+// Class to represent bitstrings of a fixed (compile-time) size
+
+/*
+ * Storage:
+ * Bits are kept in big-endian order in 64-bit words, i.e. bit i
+ * lives in words[i/64] at position 63 - i%64. Bits past N are
+ * always zero, so word-level popcounts and parities are exact.
+ * Nothing is allocated on the heap, which makes this the type of
+ * choice for the 32/48/64-bit DES hot path. The dynamic bitstring
+ * class remains the fallback for arbitrary sizes.
+ */
+
+#ifndef FIXED_BITSTRING_H
+#define FIXED_BITSTRING_H
+
+// Standard Library Imports
+#include <iostream>
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cassert>
+
+// Custom Library Imports
+#include "placement.h"
+#include "bitstring.h"
+
+// Class def
+template <int N>
+class fixed_bitstring
+{
+  static_assert(N > 0, "fixed_bitstring needs a positive size");
+
+  public:
+    // Member variables
+    static constexpr int num_words = (N + 63) / 64;     // Number of words
+    std::array<uint64_t, num_words> words;              // Words of the bitstring
+
+    // Constructors
+    constexpr fixed_bitstring() : words{} {}
+    explicit fixed_bitstring(const bitstring &other) : words{}
+    {
+        assert(other.get_size() == N);
+        for (int i = 0; i < N; i++) this->set_bit(i, other.get_bit(i));
+    }
+
+    // Read len <= 64 bits starting at start (right-aligned)
+    constexpr uint64_t read_bits(int start, int len) const
+    {
+        int w = start / 64;
+        int off = start % 64;
+        uint64_t value = this->words[w] << off;
+        if (off && w + 1 < num_words) value |= this->words[w + 1] >> (64 - off);
+        return (len == 64) ? value : (value >> (64 - len));
+    }
+
+    // Write len <= 64 bits starting at start (from the right of value)
+    constexpr void write_bits(int start, int len, uint64_t value)
+    {
+        int w = start / 64;
+        int off = start % 64;
+        uint64_t mask = (len == 64) ? ~0ULL : (~0ULL << (64 - len));
+        uint64_t aligned = (len == 64) ? value : (value << (64 - len));
+        aligned &= mask;
+        this->words[w] = (this->words[w] & ~(mask >> off)) | (aligned >> off);
+        if (off + len > 64)
+        {
+            this->words[w + 1] = (this->words[w + 1] & ~(mask << (64 - off))) | (aligned << (64 - off));
+        }
+    }
+
+    // Setters
+    constexpr void set_bit(int index, int value)                    // Set bit in big-endian
+    {
+        uint64_t bit = 1ULL << (63 - index % 64);
+        if (value) this->words[index / 64] |= bit;
+        else this->words[index / 64] &= ~bit;
+    }
+    constexpr void set_slice(int start, int end, uint64_t value)     // Set slice in big-endian
+    {
+        assert(start >= 0 && end <= N && start < end && end - start <= 64);
+        this->write_bits(start, end - start, value);
+    }
+    constexpr void set_uint64(uint64_t value)                       // Set from packed word
+    {
+        static_assert(N <= 64, "set_uint64 needs N <= 64");
+        this->words[0] = (N == 64) ? value : (value << (64 - N));
+    }
+
+    // Getters
+    static constexpr int get_size() { return N; }                   // Get size
+    constexpr int get_bit(int index) const                          // Get bit in big-endian
+    {
+        return (this->words[index / 64] >> (63 - index % 64)) & 1;
+    }
+    constexpr uint64_t get_slice_int(int start, int end) const      // Get small slice in big-endian
+    {
+        assert(start >= 0 && end <= N && start < end && end - start <= 64);
+        return this->read_bits(start, end - start);
+    }
+    template <int M>
+    constexpr fixed_bitstring<M> get_slice(int start) const         // Get slice [start, start + M)
+    {
+        assert(start >= 0 && start + M <= N);
+        fixed_bitstring<M> slice;
+        for (int i = 0; i < M; i += 64)
+        {
+            int len = (M - i < 64) ? (M - i) : 64;
+            slice.write_bits(i, len, this->read_bits(start + i, len));
+        }
+        return slice;
+    }
+    constexpr uint64_t get_uint64() const                           // Get as packed word
+    {
+        static_assert(N <= 64, "get_uint64 needs N <= 64");
+        return (N == 64) ? this->words[0] : (this->words[0] >> (64 - N));
+    }
+
+    // Get/print in string format
+    std::string get_string() const
+    {
+        std::string str = "";
+        for (int i = 0; i < N; i++) str += std::to_string(this->get_bit(i));
+        return str;
+    }
+    void print() const { std::cout << this->get_string() << std::endl; }
+
+    // Conversion to the dynamic bitstring
+    bitstring to_bitstring() const
+    {
+        bitstring result(N);
+        for (int i = 0; i < N; i++) result.set_bit(i, this->get_bit(i));
+        return result;
+    }
+
+    // Bitwise operations (word-level)
+    constexpr fixed_bitstring operator&(const fixed_bitstring &other) const
+    {
+        fixed_bitstring result;
+        for (int i = 0; i < num_words; i++) result.words[i] = this->words[i] & other.words[i];
+        return result;
+    }
+    constexpr fixed_bitstring operator|(const fixed_bitstring &other) const
+    {
+        fixed_bitstring result;
+        for (int i = 0; i < num_words; i++) result.words[i] = this->words[i] | other.words[i];
+        return result;
+    }
+    constexpr fixed_bitstring operator^(const fixed_bitstring &other) const
+    {
+        fixed_bitstring result;
+        for (int i = 0; i < num_words; i++) result.words[i] = this->words[i] ^ other.words[i];
+        return result;
+    }
+    constexpr bool operator==(const fixed_bitstring &other) const { return this->words == other.words; }
+    constexpr bool operator!=(const fixed_bitstring &other) const { return this->words != other.words; }
+
+    // Concatenation
+    template <int M>
+    constexpr fixed_bitstring<N + M> operator+(const fixed_bitstring<M> &other) const
+    {
+        fixed_bitstring<N + M> result;
+        for (int i = 0; i < N; i += 64)
+        {
+            int len = (N - i < 64) ? (N - i) : 64;
+            result.write_bits(i, len, this->read_bits(i, len));
+        }
+        for (int i = 0; i < M; i += 64)
+        {
+            int len = (M - i < 64) ? (M - i) : 64;
+            result.write_bits(N + i, len, other.read_bits(i, len));
+        }
+        return result;
+    }
+
+    // Inner product (parity of the AND)
+    constexpr int operator*(const fixed_bitstring &other) const
+    {
+        uint64_t acc = 0;
+        for (int i = 0; i < num_words; i++) acc ^= this->words[i] & other.words[i];
+        return __builtin_parityll(acc);
+    }
+
+    // Hamming weight
+    constexpr int hamming_weight() const
+    {
+        int weight = 0;
+        for (int i = 0; i < num_words; i++) weight += __builtin_popcountll(this->words[i]);
+        return weight;
+    }
+
+    // Apply placement on the bitstring
+    template <int M>
+    fixed_bitstring<M> place(const placement &p) const
+    {
+        assert(p.get_output_size() == M);
+        fixed_bitstring<M> result;
+        if constexpr (N <= 64 && M <= 64)
+        {
+            if (p.is_compiled() && p.get_input_size() == N)
+            {
+                result.set_uint64(p.place_word(this->get_uint64()));
+                return result;
+            }
+        }
+        const std::vector<int> &table = p.get_placement_table();
+        for (int i = 0; i < M; i++) result.set_bit(i, this->get_bit(table[i]));
+        return result;
+    }
+
+    // Apply inverse placement on the bitstring
+    template <int M>
+    fixed_bitstring<M> inv_place(const placement &p) const
+    {
+        assert(p.get_output_size() == N && p.get_input_size() == M);
+        fixed_bitstring<M> result;
+        if constexpr (N <= 64 && M <= 64)
+        {
+            if (p.is_compiled())
+            {
+                result.set_uint64(p.inv_place_word(this->get_uint64()));
+                return result;
+            }
+        }
+        const std::vector<int> &table = p.get_inverse_table();
+        for (int i = 0; i < M; i++) result.set_bit(i, this->get_bit(table[i]));
+        return result;
+    }
+
+    // Apply pseudo-inverse placement on the bitstring
+    template <int M>
+    fixed_bitstring<M> pseudo_inv_place(const placement &p) const
+    {
+        assert(p.get_output_size() == N && p.get_input_size() == M);
+        fixed_bitstring<M> result;
+        if constexpr (N <= 64 && M <= 64)
+        {
+            if (p.is_compiled())
+            {
+                result.set_uint64(p.pseudo_inv_place_word(this->get_uint64()));
+                return result;
+            }
+        }
+        const std::vector<int> &table = p.get_placement_table();
+        for (int i = 0; i < N; i++) result.set_bit(table[i], result.get_bit(table[i]) | this->get_bit(i));
+        return result;
+    }
+};
+
+#endif
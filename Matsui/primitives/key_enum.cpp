@@ -0,0 +1,158 @@
+// Implementation of the key enumeration
+#include "key_enum.h"
+
+// Include Libraries
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <algorithm>
+
+// Custom Library Imports
+#include "work_pool.h"
+
+// Master key bits used by the first rounds of the key schedule
+bitstring used_key_bits(feistel &cipher, int rounds)
+{
+    bitstring used(cipher.get_key_size());
+    std::vector<std::vector<int>> key_schedule = cipher.get_key_schedule();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int bit : key_schedule[r]) used.set_bit(bit, 1);
+    }
+    return used;
+}
+
+// Helper to deposit the bits of value into the given word bits (lowest first)
+static inline uint64_t deposit(uint64_t value, const std::vector<int> &positions, int from, int to)
+{
+    uint64_t word = 0;
+    for (int b = from; b < to; b++) word |= ((value >> (b - from)) & 1) << positions[b];
+    return word;
+}
+
+// Check a key against all known pairs but the first (early abort)
+static bool check_key(const feistel &cipher, int rounds, const uint64_t *round_key_words,
+                      const uint64_t *plaintexts, const uint64_t *ciphertexts, size_t pairs)
+{
+    for (size_t i = 1; i < pairs; i++)
+    {
+        if (cipher.encrypt_word(plaintexts[i], round_key_words, rounds) != ciphertexts[i]) return false;
+    }
+    return true;
+}
+
+// Search the unknown bits of a partial key on all cores
+bool search_keys(feistel &cipher, int rounds, bitstring partial_key, bitstring known_bits,
+                 const uint64_t *plaintexts, const uint64_t *ciphertexts, size_t pairs,
+                 int threads, bitstring &key, uint64_t &index, key_search_stats &stats)
+{
+    // Check if the keys and blocks fit packed words
+    int key_size = cipher.get_key_size();
+    assert(key_size <= 64 && cipher.get_block_size() <= 64);
+    assert(rounds > 0 && rounds <= cipher.get_max_rounds());
+    assert(partial_key.get_size() == key_size && known_bits.get_size() == key_size);
+    assert(pairs > 0);
+    auto start = std::chrono::steady_clock::now();
+
+    // Unknown bits (word positions, lowest first)
+    uint64_t used = used_key_bits(cipher, rounds).get_uint64();
+    uint64_t unknown = used & ~known_bits.get_uint64();
+    uint64_t base = partial_key.get_uint64() & used & ~unknown;
+    std::vector<int> positions;
+    for (int b = 0; b < 64; b++)
+    {
+        if ((unknown >> b) & 1) positions.push_back(b);
+    }
+    int u = positions.size();
+    assert(u < 63);
+
+    // Key words of every value of the low bits (one batch)
+    int low = std::min(u, KEY_LOW_BITS);
+    size_t low_count = (size_t)1 << low;
+    std::vector<uint64_t> low_words(low_count);
+    for (size_t v = 0; v < low_count; v++) low_words[v] = deposit(v, positions, 0, low);
+
+    // Chunks of whole batches (enough of them to keep every worker busy),
+    // handed out lazily in order so no chunk list is ever materialised
+    work_pool workers(threads);
+    int chunk_bits = std::max(low, std::min(KEY_CHUNK_BITS, u - 8));
+    uint64_t chunks = 1ULL << (u - chunk_bits);
+    std::atomic<uint64_t> next_chunk(0);
+    std::atomic<uint64_t> best(~0ULL);
+    std::atomic<uint64_t> tested(0);
+    const feistel &engine = cipher;
+    workers.run(workers.get_num_threads(), [&](int worker, size_t task)
+    {
+        std::vector<uint64_t> keys(low_count);
+        std::vector<uint64_t> encrypted(low_count);
+        std::vector<uint64_t> round_keys(rounds);
+        uint64_t count = 0;
+        for (uint64_t chunk = next_chunk++; chunk < chunks; chunk = next_chunk++)
+        {
+            // Chunks past a match (and so all later ones) are skipped
+            uint64_t first = chunk << chunk_bits;
+            if (first > best.load(std::memory_order_relaxed)) break;
+
+            bool found = false;
+            for (uint64_t high = first >> low; high < (first + (1ULL << chunk_bits)) >> low && !found; high++)
+            {
+                // One batch of keys on the first pair
+                uint64_t high_word = base | deposit(high, positions, low, u);
+                for (size_t v = 0; v < low_count; v++) keys[v] = high_word | low_words[v];
+                engine.encrypt_keys(plaintexts[0], keys.data(), encrypted.data(), low_count, rounds);
+                count += low_count;
+
+                // The others on a match (smallest value first)
+                for (size_t v = 0; v < low_count; v++)
+                {
+                    if (encrypted[v] != ciphertexts[0]) continue;
+                    engine.expand_key_word(keys[v], round_keys.data(), rounds);
+                    if (!check_key(engine, rounds, round_keys.data(), plaintexts, ciphertexts, pairs)) continue;
+
+                    uint64_t value = (high << low) | v;
+                    uint64_t current = best.load();
+                    while (value < current && !best.compare_exchange_weak(current, value));
+                    found = true;
+                    break;
+                }
+            }
+        }
+        tested += count;
+    });
+
+    // Statistics
+    stats.keys_tested = tested.load();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.keys_per_second = (stats.seconds > 0) ? stats.keys_tested / stats.seconds : 0;
+    if (best.load() == ~0ULL) return false;
+
+    index = best.load();
+    key = bitstring(key_size);
+    key.set_uint64(base | deposit(index, positions, 0, u));
+    return true;
+}
+
+// Try the candidates in rank order against known pairs
+bool enumerate_keys(feistel &cipher, int rounds, const std::vector<key_candidate> &candidates,
+                    const uint64_t *plaintexts, const uint64_t *ciphertexts, size_t pairs,
+                    bitstring &key, size_t &rank, uint64_t &keys_tested, int threads)
+{
+    uint64_t used = used_key_bits(cipher, rounds).get_uint64();
+    keys_tested = 0;
+    for (rank = 0; rank < candidates.size(); rank++)
+    {
+        // Whole space of the candidate, or up to the match
+        const key_candidate &candidate = candidates[rank];
+        uint64_t index;
+        key_search_stats stats;
+        if (search_keys(cipher, rounds, candidate.partial_key, candidate.known_bits,
+                        plaintexts, ciphertexts, pairs, threads, key, index, stats))
+        {
+            keys_tested += index + 1;
+            return true;
+        }
+        keys_tested += 1ULL << __builtin_popcountll(used & ~candidate.known_bits.get_uint64());
+    }
+    return false;
+}
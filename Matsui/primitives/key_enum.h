@@ -0,0 +1,74 @@
+// Full-key recovery from ranked partial-key candidates
+
+/*
+ * Enumeration:
+ * Every candidate fixes some master key bits (the key bits of the
+ * active S-Boxes). The master key bits the first rounds actually use,
+ * minus the fixed ones, are unknown; for each candidate in rank order
+ * all their 2^u values are tried. Master key bits that no round uses
+ * (eg, the DES parity bits) are left at zero.
+ */
+
+/*
+ * Exhaustive search:
+ * Value i of the unknown bits is i deposited into their positions
+ * (lowest bit first), so the search order is fixed. The low
+ * KEY_LOW_BITS bits form one batch of keys, which feistel::encrypt_keys
+ * encrypts key-sliced on the bitsliced engine (SLICE_LANES keys per
+ * pass, lane j under key j); the first known pair is checked for the
+ * whole batch, the others only for a key that matches it. Chunks of
+ * up to 2^KEY_CHUNK_BITS values are handed out in order from an atomic
+ * counter to the workers, so even 2^60 values need no task list. The
+ * smallest matching value is returned, whatever the number of threads.
+ */
+
+#ifndef KEY_ENUM_H
+#define KEY_ENUM_H
+
+// Standard Library Imports
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Custom Library Imports
+#include "bitstring.h"
+#include "feistel.h"
+
+// Low unknown bits enumerated per batch (keys encrypted together)
+#define KEY_LOW_BITS 10
+
+// Largest chunk of the search (values of the unknown bits per task)
+#define KEY_CHUNK_BITS 20
+
+// Ranked candidate of a partial key recovery
+struct key_candidate
+{
+  bitstring partial_key;            // Master key with the guessed bits set (others zero)
+  bitstring known_bits;             // Master key bits fixed by the guess
+  int64_t score;                    // Ranking score (signed)
+  int rhs;                          // Key parity implied by the sign of the score
+};
+
+// Statistics of an exhaustive search
+struct key_search_stats
+{
+  uint64_t keys_tested = 0;         // Keys encrypted (all workers)
+  double seconds = 0;               // Wall time
+  double keys_per_second = 0;       // keys_tested / seconds
+};
+
+// Master key bits used by the first rounds of the key schedule
+bitstring used_key_bits(feistel &cipher, int rounds);
+
+// Search the unknown bits of a partial key on all cores (false if no key matches)
+bool search_keys(feistel &cipher, int rounds, bitstring partial_key, bitstring known_bits,
+                 const uint64_t *plaintexts, const uint64_t *ciphertexts, size_t pairs,
+                 int threads, bitstring &key, uint64_t &index, key_search_stats &stats);
+
+// Try the candidates in rank order against known pairs (false if none matches);
+// keys_tested is the work factor, the keys before the match in search order
+bool enumerate_keys(feistel &cipher, int rounds, const std::vector<key_candidate> &candidates,
+                    const uint64_t *plaintexts, const uint64_t *ciphertexts, size_t pairs,
+                    bitstring &key, size_t &rank, uint64_t &keys_tested, int threads = 0);
+
+#endif
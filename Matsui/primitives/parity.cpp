@@ -0,0 +1,96 @@
+// Implementation of the bulk parity engine
+#include "parity.h"
+
+// Include Libraries
+#include <vector>
+#include <cassert>
+#include <algorithm>
+
+// Custom Library Imports
+#include "bitslice.h"
+
+// Constructors and Destructors
+parity_slices::parity_slices()
+{
+    this->count = 0;
+    this->words = 0;
+}
+
+parity_slices::~parity_slices()
+{
+    // Destructor Logic
+}
+
+// Transpose a batch of blocks
+void parity_slices::load(const uint64_t *blocks, size_t count)
+{
+    this->count = count;
+    this->words = (count + 63) / 64;
+    this->slices.resize(64 * this->words);
+
+    for (size_t w = 0; w < this->words; w++)
+    {
+        // Rows are blocks before, bits after (bit b lands in row 63 - b)
+        uint64_t rows[64];
+        for (size_t j = 0; j < 64; j++)
+        {
+            size_t index = 64*w + j;
+            rows[j] = (index < count) ? blocks[index] : 0;
+        }
+        transpose_64(rows);
+        for (int b = 0; b < 64; b++) this->slices[b*this->words + w] = rows[63 - b];
+    }
+}
+
+// Parity bitmap of a mask
+void parity_slices::parities(uint64_t mask, uint64_t *bitmap) const
+{
+    std::fill(bitmap, bitmap + this->words, 0);
+    for (; mask; mask &= mask - 1)
+    {
+        const uint64_t *slice = this->get_slice(__builtin_ctzll(mask));
+        for (size_t w = 0; w < this->words; w++) bitmap[w] ^= slice[w];
+    }
+}
+
+// Blocks where the parity of mask_a on a equals the parity of mask_b on b
+uint64_t count_agreements(const parity_slices &a, uint64_t mask_a,
+                          const parity_slices &b, uint64_t mask_b)
+{
+    // Check if the batches match
+    assert(a.get_count() == b.get_count());
+
+    // Slices of the set bits
+    const uint64_t *rows[128];
+    int num_rows = 0;
+    for (; mask_a; mask_a &= mask_a - 1) rows[num_rows++] = a.get_slice(__builtin_ctzll(mask_a));
+    for (; mask_b; mask_b &= mask_b - 1) rows[num_rows++] = b.get_slice(__builtin_ctzll(mask_b));
+
+    // Disagreements, 64 words at a time
+    uint64_t differ = 0;
+    size_t words = a.get_words();
+    for (size_t base = 0; base < words; base += 64)
+    {
+        size_t span = std::min<size_t>(64, words - base);
+        uint64_t acc[64] = {0};
+        for (int r = 0; r < num_rows; r++)
+        {
+            const uint64_t *row = rows[r] + base;
+            for (size_t w = 0; w < span; w++) acc[w] ^= row[w];
+        }
+        for (size_t w = 0; w < span; w++) differ += __builtin_popcountll(acc[w]);
+    }
+    return a.get_count() - differ;
+}
+
+// Same for every pair of masks
+void count_agreements(const parity_slices &a, const std::vector<uint64_t> &masks_a,
+                      const parity_slices &b, const std::vector<uint64_t> &masks_b,
+                      uint64_t *counts)
+{
+    assert(masks_a.size() == masks_b.size());
+    for (size_t i = 0; i < masks_a.size(); i++)
+    {
+        counts[i] += count_agreements(a, masks_a[i], b, masks_b[i]);
+    }
+}
@@ -0,0 +1,63 @@
+// Bulk evaluation of mask parities over batches of packed blocks
+
+/*
+ * Parity slices:
+ * A batch of packed blocks is transposed 64 blocks at a time, so
+ * slice b holds bit b (of the packed word) of every block, 64
+ * blocks per word. Within word w, block 64w + c sits at bit 63 - c.
+ * The parity bitmap of a mask is then the xor of the slices of its
+ * set bits, i.e. weight(mask) word xors per 64 blocks instead of
+ * one AND + parity per block. Missing blocks of the last word are
+ * zero, so they never contribute a disagreement.
+ */
+
+/*
+ * Agreements:
+ * Two parity bitmaps (say input mask on plaintexts and output mask
+ * on ciphertexts) agree on a block when their xor is 0, so the
+ * number of agreements is count - popcount(xor). Masks are scanned
+ * 64 words at a time so the xors stay in registers/L1.
+ */
+
+#ifndef PARITY_H
+#define PARITY_H
+
+// Standard Library Imports
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class parity_slices
+{
+  private:
+    size_t count;                               // Number of blocks
+    size_t words;                               // Words per slice
+    std::vector<uint64_t> slices;               // Slices [bit][word]
+
+  public:
+    // Constructors & Destructors
+    parity_slices();
+    ~parity_slices();
+
+    // Transpose a batch of blocks (reuses the storage)
+    void load(const uint64_t *blocks, size_t count);
+
+    // Accessors
+    size_t get_count() const { return this->count; }
+    size_t get_words() const { return this->words; }
+    const uint64_t *get_slice(int bit) const { return this->slices.data() + bit*this->words; }
+
+    // Parity bitmap of a mask (get_words() words)
+    void parities(uint64_t mask, uint64_t *bitmap) const;
+};
+
+// Blocks where the parity of mask_a on a equals the parity of mask_b on b
+uint64_t count_agreements(const parity_slices &a, uint64_t mask_a,
+                          const parity_slices &b, uint64_t mask_b);
+
+// Same for every pair (masks_a[i], masks_b[i]), added to counts[i]
+void count_agreements(const parity_slices &a, const std::vector<uint64_t> &masks_a,
+                      const parity_slices &b, const std::vector<uint64_t> &masks_b,
+                      uint64_t *counts);
+
+#endif
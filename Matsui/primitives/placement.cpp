@@ -14,6 +14,7 @@ placement::placement()
     this->output_size = 0;
     this->placement_table = {};
     this->inverse_table = {};
+    this->invertible = false;
 }
 
 placement::placement(int input_size, int output_size, std::vector<int> placement_table)
@@ -26,9 +27,13 @@ placement::placement(int input_size, int output_size, std::vector<int> placement
     this->input_size = input_size;
     this->output_size = output_size;
     this->placement_table = placement_table;
+    this->invertible = false;
 
     // Compute inverse table
     if(input_size == output_size) this->compute_inv();
+
+    // Compile word-level kernels
+    if (input_size <= 64 && output_size <= 64) this->compile();
 }
 
 placement::~placement()
@@ -68,13 +73,140 @@ void placement::compute_inv()
     return;
 }
 
+// Helper to build byte-indexed OR-tables from (source bit, destination bit) pairs
+static std::vector<uint64_t> build_kernel(int src_size, int dst_size, const std::vector<std::pair<int, int>> &edges)
+{
+    // Single-bit contributions of every (zero-padded) source byte
+    int num_bytes = (src_size + 7)/8;
+    std::vector<uint64_t> kernel(num_bytes * 256, 0);
+    for (size_t e = 0; e < edges.size(); e++)
+    {
+        int src = edges[e].first;
+        int dst = edges[e].second;
+        kernel[(src/8)*256 + (1 << (7 - src%8))] |= 1ULL << (dst_size - 1 - dst);
+    }
+
+    // Every other byte value is the OR of its bits
+    for (int b = 0; b < num_bytes; b++)
+    {
+        uint64_t *table = kernel.data() + b*256;
+        for (int v = 1; v < 256; v++)
+        {
+            int low = v & -v;
+            if (v != low) table[v] = table[v ^ low] | table[low];
+        }
+    }
+
+    return kernel;
+}
+
+// Helper to apply a byte-indexed kernel
+static inline uint64_t apply_kernel(const std::vector<uint64_t> &kernel, int src_size, uint64_t input)
+{
+    int num_bytes = kernel.size() / 256;
+    uint64_t padded = input << (8*num_bytes - src_size);
+    uint64_t output = 0;
+    for (int b = 0; b < num_bytes; b++)
+    {
+        output |= kernel[b*256 + ((padded >> (8*(num_bytes - 1 - b))) & 0xFF)];
+    }
+    return output;
+}
+
+// Compile word-level kernels
+void placement::compile()
+{
+    // Check if the sizes fit in a word
+    assert(this->input_size <= 64 && this->output_size <= 64);
+
+    std::shared_ptr<placement_kernels> compiled = std::make_shared<placement_kernels>();
+    std::vector<std::pair<int, int>> edges;
+
+    // place: output bit i reads input bit placement_table[i]
+    for (int i = 0; i < this->output_size; i++) edges.push_back(std::make_pair(this->placement_table[i], i));
+    compiled->forward = build_kernel(this->input_size, this->output_size, edges);
+
+    // pseudo_inv_place: input bit placement_table[i] collects output bit i
+    edges.clear();
+    for (int i = 0; i < this->output_size; i++) edges.push_back(std::make_pair(i, this->placement_table[i]));
+    compiled->pseudo_inv = build_kernel(this->output_size, this->input_size, edges);
+
+    // inv_place: input bit i reads output bit inverse_table[i]
+    if (this->invertible)
+    {
+        edges.clear();
+        for (int i = 0; i < this->input_size; i++) edges.push_back(std::make_pair(this->inverse_table[i], i));
+        compiled->inverse = build_kernel(this->output_size, this->input_size, edges);
+    }
+
+    this->kernels = compiled;
+}
+
 // Accessors
-std::vector<int> placement::get_placement_table() const
+const std::vector<int> &placement::get_placement_table() const
 {
     return this->placement_table;
 }
 
-std::vector<int> placement::get_inverse_table() const
+const std::vector<int> &placement::get_inverse_table() const
 {
     return this->inverse_table;
 }
+
+// Apply placement on a packed word
+uint64_t placement::place_word(uint64_t input) const
+{
+    // Check if the sizes fit in a word
+    assert(this->input_size <= 64 && this->output_size <= 64);
+
+    // Compiled kernel
+    if (this->kernels) return apply_kernel(this->kernels->forward, this->input_size, input);
+
+    // Output bit i reads input bit placement_table[i]
+    uint64_t output = 0;
+    for (int i = 0; i < this->output_size; i++)
+    {
+        uint64_t bit = (input >> (this->input_size - 1 - this->placement_table[i])) & 1;
+        output |= bit << (this->output_size - 1 - i);
+    }
+    return output;
+}
+
+// Apply inverse placement on a packed word
+uint64_t placement::inv_place_word(uint64_t input) const
+{
+    // Check if the placement is invertible and fits in a word
+    assert(this->invertible);
+    assert(this->input_size <= 64);
+
+    // Compiled kernel
+    if (this->kernels) return apply_kernel(this->kernels->inverse, this->output_size, input);
+
+    // Output bit i reads input bit inverse_table[i]
+    uint64_t output = 0;
+    for (int i = 0; i < this->input_size; i++)
+    {
+        uint64_t bit = (input >> (this->output_size - 1 - this->inverse_table[i])) & 1;
+        output |= bit << (this->input_size - 1 - i);
+    }
+    return output;
+}
+
+// Apply pseudo-inverse placement on a packed word
+uint64_t placement::pseudo_inv_place_word(uint64_t input) const
+{
+    // Check if the sizes fit in a word
+    assert(this->input_size <= 64 && this->output_size <= 64);
+
+    // Compiled kernel
+    if (this->kernels) return apply_kernel(this->kernels->pseudo_inv, this->output_size, input);
+
+    // Input bit placement_table[i] collects output bit i
+    uint64_t output = 0;
+    for (int i = 0; i < this->output_size; i++)
+    {
+        uint64_t bit = (input >> (this->output_size - 1 - i)) & 1;
+        output |= bit << (this->input_size - 1 - this->placement_table[i]);
+    }
+    return output;
+}
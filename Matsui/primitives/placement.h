@@ -9,10 +9,27 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <cstdint>
+#include <memory>
 
 // Custom Library Imports
 // None for now
 
+/*
+ * Compiled kernels:
+ * A placement on at most 64 bits is compiled into byte-indexed
+ * OR-tables: for every input byte and each of its 256 values,
+ * the word holding the output bits that byte contributes. One
+ * application then costs one lookup per input byte. Kernels are
+ * shared between copies of the same placement.
+ */
+struct placement_kernels
+{
+  std::vector<uint64_t> forward;    // place       (input -> output)
+  std::vector<uint64_t> inverse;    // inv_place   (output -> input, if invertible)
+  std::vector<uint64_t> pseudo_inv; // pseudo_inv_place (output -> input)
+};
+
 class placement
 {
   private:
@@ -21,6 +38,7 @@ class placement
     std::vector<int> placement_table; // Placement table
     std::vector<int> inverse_table;   // Inverse placement table (if invertible, otherwise empty)
     bool invertible; // Flag to check if the placement is invertible
+    std::shared_ptr<const placement_kernels> kernels; // Compiled kernels (null if not compiled)
 
   public:
     // Constructors & Destructors
@@ -28,12 +46,20 @@ class placement
     placement(int input_size, int output_size, std::vector<int> placement_table);
     ~placement();
     void compute_inv();
+    void compile();         // Build word-level kernels (sizes <= 64)
 
     // Accessors
     int get_input_size() const { return this->input_size; }
     int get_output_size() const { return this->output_size; }
-    std::vector<int> get_placement_table() const;
-    std::vector<int> get_inverse_table() const;
+    const std::vector<int> &get_placement_table() const;
+    const std::vector<int> &get_inverse_table() const;
+    bool is_invertible() const { return this->invertible; }
+    bool is_compiled() const { return this->kernels != nullptr; }
+
+    // Apply placement on packed words (sizes <= 64, big-endian)
+    uint64_t place_word(uint64_t input) const;
+    uint64_t inv_place_word(uint64_t input) const;
+    uint64_t pseudo_inv_place_word(uint64_t input) const;
 
     // Apply placement on any vector-template
     template <typename T>
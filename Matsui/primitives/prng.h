@@ -0,0 +1,87 @@
+// Fast seeded generators for data collection
+
+/*
+ * Streams:
+ * xoshiro256** generates the random words. A generator is seeded
+ * from a master seed and a stream index through splitmix64, so the
+ * data of stream i is fixed by (seed, i) alone. Splitting the data
+ * into streams of fixed length makes a parallel run reproducible
+ * whatever the number of threads.
+ */
+
+/*
+ * Counter-based PRF:
+ * prf64(seed, i) hashes the index with a key derived from the seed
+ * (two keyed rounds of the splitmix64 finaliser, a bijection of i),
+ * so word i can be computed on its own, on any core or machine.
+ */
+
+#ifndef PRNG_H
+#define PRNG_H
+
+// Standard Library Imports
+#include <cstdint>
+#include <cstddef>
+
+// splitmix64 finaliser (a bijection of 64-bit words)
+static inline uint64_t mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// splitmix64 step (advances the state)
+static inline uint64_t splitmix64(uint64_t &state)
+{
+    return mix64(state += 0x9E3779B97F4A7C15ULL);
+}
+
+// Word i of the PRF keyed by the seed
+static inline uint64_t prf64(uint64_t seed, uint64_t index)
+{
+    uint64_t key = mix64(seed ^ 0x6A09E667F3BCC909ULL);
+    uint64_t x = mix64(index * 0x9E3779B97F4A7C15ULL + key);
+    return mix64(x ^ (key >> 32 | key << 32));
+}
+
+class xoshiro256
+{
+  private:
+    uint64_t s[4];                              // Generator state
+
+    static inline uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  public:
+    // Constructors & Destructors
+    xoshiro256(uint64_t seed, uint64_t stream = 0)
+    {
+        uint64_t state = seed;
+        state = splitmix64(state) ^ stream;
+        for (int i = 0; i < 4; i++) this->s[i] = splitmix64(state);
+    }
+
+    // Next random word
+    uint64_t next()
+    {
+        uint64_t result = rotl(this->s[1] * 5, 7) * 9;
+        uint64_t t = this->s[1] << 17;
+        this->s[2] ^= this->s[0];
+        this->s[3] ^= this->s[1];
+        this->s[1] ^= this->s[2];
+        this->s[0] ^= this->s[3];
+        this->s[2] ^= t;
+        this->s[3] = rotl(this->s[3], 45);
+        return result;
+    }
+};
+
+// Random packed blocks of the given size from stream (seed, stream)
+static inline void random_blocks(uint64_t seed, uint64_t stream, uint64_t *blocks, size_t count, int block_size)
+{
+    uint64_t mask = (block_size == 64) ? ~0ULL : ((1ULL << block_size) - 1);
+    xoshiro256 rng(seed, stream);
+    for (size_t i = 0; i < count; i++) blocks[i] = rng.next() & mask;
+}
+
+#endif
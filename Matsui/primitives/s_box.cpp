@@ -6,20 +6,12 @@
 #include <vector>
 #include <cassert>
 #include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
 
-// Bitwise Dot-product
-int dot_product(int a, int b, int n)
-{
-  // Assert that the inputs are valid
-  int N = (1 << n);
-  assert(a < N);
-  assert(b < N);
-
-  // Compute 
-  int res = 0;
-  for (int i = 0; i < n; i++) res ^= ((a >> i) & 1) & ((b >> i) & 1);
-  return res;
-}
+// Custom Library Imports
+#include "walsh.h"
 
 // Comparision function for sorting LAT entries
 bool gt_lat(const lat_entry &a, const lat_entry &b)
@@ -34,6 +26,7 @@ s_box::s_box(int in, int out, std::vector<int> table)
 {
     // Check if the input and output sizes are valid
     assert(in > 0 && out > 0);
+    assert(in <= 15); // LAT counts up to 2^(in-1) must fit int16
     assert(table.size() == (1 << in));
     for (int i = 0; i < table.size(); i++) assert(table[i] >= 0 && table[i] < (1 << out));
 
@@ -54,7 +47,7 @@ s_box::~s_box()
 }
 
 // Accessors
-int s_box::eval(int input)
+int s_box::eval(int input) const
 {
     // Check if the input is valid
     assert(input >= 0 && input < (1 << this->in));
@@ -69,54 +62,124 @@ std::vector<int> s_box::get_table()
     return this->table;
 }
 
-std::vector<lat_entry> s_box::get_lat()
+const std::vector<lat_entry> &s_box::get_lat() const
 {
-    // Return the Linear Approximation Table
-    return this->lat;
+    // Return the (sorted) Linear Approximation Table
+    return this->lat->sorted;
 }
 
-// Linear Analysis
-void s_box::gen_lat()
+const std::vector<int16_t> &s_box::get_lat_dense() const
+{
+    // Return the dense Linear Approximation Table
+    return this->lat->dense;
+}
+
+int s_box::get_lat_value(int input_mask, int output_mask) const
 {
-    // Resize the LAT
-    int N = (1 << this->in);
-    int M = (1 << this->out);
-    std::vector<float> values(N * M, 0);
+    // Check if the masks are valid
+    assert(input_mask >= 0 && input_mask < this->lat->n);
+    assert(output_mask >= 0 && output_mask < this->lat->m);
 
-    // Compute the LAT
-    for (int x = 0; x < N; x++)
+    // Return the bias count
+    return this->lat->dense[input_mask*this->lat->m + output_mask];
+}
+
+// Linear Analysis
+// Compute the LAT of a table (no shared state)
+static std::shared_ptr<const lat_data> compute_lat(int in, int out, const std::vector<int> &table)
+{
+    // Dense LAT, one Walsh-Hadamard transform per output mask
+    int N = (1 << in);
+    int M = (1 << out);
+    std::shared_ptr<lat_data> data = std::make_shared<lat_data>();
+    data->n = N;
+    data->m = M;
+    data->table = table;
+    data->dense.resize(N * M);
+    std::vector<int> spectrum(N);
+    for (int b = 0; b < M; b++)
     {
-        int y = this->eval(x);
-        for (int a = 0; a < N; a++)
-        {
-           int xa = dot_product(x, a, this->in); 
-           for (int b = 0; b < M; b++)
-           {
-               int yb = dot_product(y, b, this->out);
-               values[b*N + a] += ((xa ^ yb) ? -1 : 1);
-           }
-        }
+        // (-1)^(b.S(x)), transformed into sum_x (-1)^(b.S(x) + a.x)
+        for (int x = 0; x < N; x++) spectrum[x] = __builtin_parity(b & table[x]) ? -1 : 1;
+        fwht(spectrum.data(), N);
+        for (int a = 0; a < N; a++) data->dense[a*M + b] = spectrum[a]/2;
     }
 
-    // Create LAT
-    std::vector<lat_entry> lat;
+    // Create sorted LAT
+    data->sorted.reserve(N * M);
     for (int a = 0; a < N; a++)
     {
         for (int b = 0; b < M; b++)
         {
             lat_entry entry;
-            entry.bias = values[b*N + a]/2;
+            entry.bias = data->dense[a*M + b];
             entry.a = a;
             entry.b = b;
-            lat.push_back(entry);
+            data->sorted.push_back(entry);
         }
     }
+    std::sort(data->sorted.begin(), data->sorted.end(), gt_lat);
 
-    // Sort the LAT
-    std::sort(lat.begin(), lat.end(), gt_lat);
+    // Index by input and output mask (keeps the sorted order)
+    data->by_inp.resize(N);
+    data->by_out.resize(M);
+    for (size_t i = 0; i < data->sorted.size(); i++)
+    {
+        data->by_inp[data->sorted[i].a].push_back(data->sorted[i]);
+        data->by_out[data->sorted[i].b].push_back(data->sorted[i]);
+    }
+
+    return data;
+}
+
+void s_box::gen_lat()
+{
+    /*
+     * Registry of the live LATs, keyed by a hash of the sizes and table
+     * (the table itself is held once, by the LAT). Entries whose LAT
+     * expired are dropped on every registration, so the registry never
+     * outgrows the live LATs; the LAT is computed outside the lock.
+     */
+    typedef std::unordered_multimap<uint64_t, std::weak_ptr<const lat_data>> lat_registry;
+    static lat_registry registry;
+    static std::mutex registry_mutex;
+
+    // FNV-1a hash of the sizes and table
+    uint64_t key = 14695981039346656037ULL;
+    for (int value : {this->in, this->out}) key = (key ^ (uint32_t)value) * 1099511628211ULL;
+    for (int value : this->table) key = (key ^ (uint32_t)value) * 1099511628211ULL;
+
+    // Live LAT of an identical table, if any (caller holds the lock)
+    auto lookup = [&]() -> std::shared_ptr<const lat_data>
+    {
+        auto range = registry.equal_range(key);
+        for (lat_registry::iterator it = range.first; it != range.second; it++)
+        {
+            std::shared_ptr<const lat_data> shared = it->second.lock();
+            if (shared && shared->table == this->table) return shared;
+        }
+        return nullptr;
+    };
+
+    // Reuse the LAT of an identical table if one is alive
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        this->lat = lookup();
+        if (this->lat) return;
+    }
 
-    // Store the sorted LAT
-    this->lat = lat;
+    // Compute, then register unless another thread registered it first
+    std::shared_ptr<const lat_data> data = compute_lat(this->in, this->out, this->table);
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    this->lat = lookup();
+    if (this->lat) return;
+    for (lat_registry::iterator it = registry.begin(); it != registry.end();)
+    {
+        if (it->second.expired()) it = registry.erase(it);
+        else it++;
+    }
+    registry.emplace(key, data);
+    this->lat = data;
 }
 
 // Get LAT entries above a threshold
@@ -124,12 +187,12 @@ std::vector<lat_entry> s_box::get_lat_thr(int thr)
 {
     // Create a vector to store the entries above the threshold
     std::vector<lat_entry> lat_thr;
-    for (int i = 0; i < this->lat.size(); i++)
+    for (int i = 0; i < this->lat->sorted.size(); i++)
     {
-        int abs_bias = (this->lat[i].bias < 0) ? -this->lat[i].bias : this->lat[i].bias;
+        int abs_bias = (this->lat->sorted[i].bias < 0) ? -this->lat->sorted[i].bias : this->lat->sorted[i].bias;
         if (abs_bias >= thr)
         {
-            lat_thr.push_back(this->lat[i]);
+            lat_thr.push_back(this->lat->sorted[i]);
         }
         else break;
     }
@@ -141,9 +204,9 @@ std::vector<lat_entry> s_box::get_lat_top(int top)
 {
     // Create a vector to store the top N entries
     std::vector<lat_entry> lat_top;
-    for (int i = 0; i < top && i < this->lat.size(); i++)
+    for (int i = 0; i < top && i < this->lat->sorted.size(); i++)
     {
-        lat_top.push_back(this->lat[i]);
+        lat_top.push_back(this->lat->sorted[i]);
     }
     return lat_top;
 }
@@ -151,46 +214,69 @@ std::vector<lat_entry> s_box::get_lat_top(int top)
 // Get the top LAT entry for a given input mask 
 lat_entry s_box::get_lat_top_inp(int input_mask)
 {
-    // Create a vector to store the top entry
-    lat_entry lat_top;
-    for (int i = 0; i < this->lat.size(); i++)
-    {
-        if ((this->lat[i].a == input_mask))
-        {
-            lat_top = this->lat[i];
-            break;
-        }
-    }
-    return lat_top;
+    // First entry of the input mask bucket
+    lat_span entries = this->get_lat_inp(input_mask);
+    return entries.empty() ? lat_entry() : entries[0];
 }
 
 // Get the top LAT entry for a given output mask
 lat_entry s_box::get_lat_top_out(int output_mask)
 {
-    // Create a vector to store the top entry
-    lat_entry lat_top;
-    for (int i = 0; i < this->lat.size(); i++)
-    {
-        if ((this->lat[i].b == output_mask))
-        {
-            lat_top = this->lat[i];
-            break;
-        }
-    }
-    return lat_top;
+    // First entry of the output mask bucket
+    lat_span entries = this->get_lat_out(output_mask);
+    return entries.empty() ? lat_entry() : entries[0];
 }
 
 // Get the LAT entries for a given output mask
 std::vector<lat_entry> s_box::get_lat_outs(int output_mask)
 {
-    // Create a vector to store the entries
-    std::vector<lat_entry> lat_outs;
-    for (int i = 0; i < this->lat.size(); i++)
+    // Copy of the output mask bucket
+    lat_span entries = this->get_lat_out(output_mask);
+    return std::vector<lat_entry>(entries.begin(), entries.end());
+}
+
+// Helper to view a bucket (optionally cut at a bias threshold)
+static lat_span bucket_span(const std::vector<lat_entry> &bucket, int thr)
+{
+    lat_span span;
+    span.first = bucket.data();
+    span.last = bucket.data() + bucket.size();
+    if (thr > 0)
     {
-        if ((this->lat[i].b == output_mask))
+        // Buckets are sorted by |bias|, so the matches form a prefix
+        span.last = std::partition_point(span.first, span.last, [thr](const lat_entry &entry)
         {
-            lat_outs.push_back(this->lat[i]);
-        }
+            int abs_bias = (entry.bias < 0) ? -entry.bias : entry.bias;
+            return abs_bias >= thr;
+        });
     }
-    return lat_outs;
+    return span;
+}
+
+// Get the LAT entries for a given input mask
+lat_span s_box::get_lat_inp(int input_mask) const
+{
+    assert(input_mask >= 0 && input_mask < this->lat->n);
+    return bucket_span(this->lat->by_inp[input_mask], 0);
+}
+
+// Get the LAT entries for a given output mask
+lat_span s_box::get_lat_out(int output_mask) const
+{
+    assert(output_mask >= 0 && output_mask < this->lat->m);
+    return bucket_span(this->lat->by_out[output_mask], 0);
+}
+
+// Get the LAT entries for a given input mask with |bias| >= thr
+lat_span s_box::get_lat_inp_thr(int input_mask, int thr) const
+{
+    assert(input_mask >= 0 && input_mask < this->lat->n);
+    return bucket_span(this->lat->by_inp[input_mask], thr);
+}
+
+// Get the LAT entries for a given output mask with |bias| >= thr
+lat_span s_box::get_lat_out_thr(int output_mask, int thr) const
+{
+    assert(output_mask >= 0 && output_mask < this->lat->m);
+    return bucket_span(this->lat->by_out[output_mask], thr);
 }
@@ -8,6 +8,8 @@
 #include <iostream>
 #include <vector>
 #include <utility>
+#include <memory>
+#include <cstdint>
 
 // Struct definition for LAT entries
 struct lat_entry
@@ -21,6 +23,31 @@ struct lat_entry
 // Comparision function for sorting LAT entries
 bool gt_lat(const lat_entry &a, const lat_entry &b);
 
+// Linear Approximation Table of one S-Box table (shared between S-Boxes
+// with the same table, so it is computed once per distinct table)
+struct lat_data
+{
+  int n = 0;                        // Number of input masks (2^in)
+  int m = 0;                        // Number of output masks (2^out)
+  std::vector<int> table;           // S-Box table the LAT belongs to
+  std::vector<int16_t> dense;       // Bias counts, dense[a*m + b] (|count| <= 2^(in-1), so in <= 15)
+  std::vector<lat_entry> sorted;    // All entries sorted by |bias|
+  std::vector<std::vector<lat_entry>> by_inp;  // Entries per input mask (sorted by |bias|)
+  std::vector<std::vector<lat_entry>> by_out;  // Entries per output mask (sorted by |bias|)
+};
+
+// Read-only view over a run of LAT entries
+struct lat_span
+{
+  const lat_entry *first = nullptr;
+  const lat_entry *last = nullptr;
+  const lat_entry *begin() const { return first; }
+  const lat_entry *end() const { return last; }
+  size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+  const lat_entry &operator[](size_t i) const { return first[i]; }
+};
+
 // Class definition for S-Box
 class s_box
 {
@@ -28,7 +55,7 @@ class s_box
     std::vector<int> table;         // S-Box table
     int in;                    // Input size
     int out;                   // Output size
-    std::vector<lat_entry> lat;              // Linear Approximation Table
+    std::shared_ptr<const lat_data> lat;     // Linear Approximation Table (shared)
 
   public:
     // Constructors & Destructors
@@ -36,9 +63,11 @@ class s_box
     ~s_box();
 
     // Accessors
-    int eval(int input);
+    int eval(int input) const;
     std::vector<int> get_table();
-    std::vector<lat_entry> get_lat();
+    const std::vector<lat_entry> &get_lat() const;
+    const std::vector<int16_t> &get_lat_dense() const;
+    int get_lat_value(int input_mask, int output_mask) const;
 
     // Linear Analysis
     void gen_lat();
@@ -47,6 +76,12 @@ class s_box
     lat_entry get_lat_top_inp(int input_mask);
     lat_entry get_lat_top_out(int output_mask);
     std::vector<lat_entry> get_lat_outs(int output_mask);
+
+    // Indexed LAT queries (sorted by |bias|, no copies)
+    lat_span get_lat_inp(int input_mask) const;
+    lat_span get_lat_out(int output_mask) const;
+    lat_span get_lat_inp_thr(int input_mask, int thr) const;
+    lat_span get_lat_out_thr(int output_mask, int thr) const;
 };
 
 #endif
@@ -0,0 +1,510 @@
+// Implementation of the linear trail search
+#include "trail_search.h"
+
+// Include Libraries
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+// Print a trail
+void print_state(const trail_state &state)
+{
+    // Print the trail
+    std::cout << "Trail over " << state.total_rounds << " rounds, bias: " << state.bias << std::endl;
+
+    // Print roundwise info
+    for (int i = 0; i < state.total_rounds; i++)
+    {
+        bitstring input_mask = state.input_masks[i];
+        bitstring output_mask = state.output_masks[i];
+        std::cout << "Round " << i + 1 << " (bias " << state.round_biases[i] << ")" << std::endl;
+        std::cout << "  Input Mask:  " << input_mask.get_string() << std::endl;
+        std::cout << "  Output Mask: " << output_mask.get_string() << std::endl;
+
+        // Print active S-Boxes
+        for (int j = 0; j < state.total_sboxes; j++)
+        {
+            int index = i*state.total_sboxes + j;
+            if (state.betas[index] == 0) continue;
+            std::cout << "  S-Box " << j + 1 << ": Alpha: " << state.alphas[index]
+                      << ", Beta: " << state.betas[index]
+                      << ", Bias: " << state.s_box_biases[index] << std::endl;
+        }
+    }
+}
+
+// Constructors and Destructors
+trail_search::trail_search(int block_size, std::vector<s_box> sboxes,
+                           placement prev_sbox, placement post_sbox)
+{
+    // Check if the parameters are valid
+    assert(block_size > 0 && block_size % 2 == 0 && block_size/2 <= 64);
+    assert(sboxes.size() > 0);
+
+    // Populate
+    this->half = block_size/2;
+    this->num_sboxes = sboxes.size();
+    this->sbox_in = prev_sbox.get_output_size() / this->num_sboxes;
+    this->sbox_out = post_sbox.get_input_size() / this->num_sboxes;
+    this->scale = 1.0 / (1 << (this->sbox_in - 1));
+    this->sboxes = sboxes;
+    this->rounds = 0;
+    this->pool = nullptr;
+    this->cut = -1;
+    this->tasks = nullptr;
+    this->bounds.push_back(1.0);
+
+    // Check if the masks fit the packed words
+    int layer_out = this->sbox_out * this->num_sboxes;
+    assert(layer_out <= 64 && this->sbox_in <= 16);
+    assert(prev_sbox.get_input_size() == this->half && post_sbox.get_output_size() == this->half);
+
+    // Round input mask of every S-Box input mask (transpose of the expansion)
+    const std::vector<int> &prev = prev_sbox.get_placement_table();
+    this->alpha_words.assign(this->num_sboxes, std::vector<uint64_t>(1 << this->sbox_in, 0));
+    for (int j = 0; j < this->num_sboxes; j++)
+    {
+        for (int a = 0; a < (1 << this->sbox_in); a++)
+        {
+            for (int t = 0; t < this->sbox_in; t++)
+            {
+                if ((a >> (this->sbox_in - 1 - t)) & 1)
+                {
+                    this->alpha_words[j][a] ^= 1ULL << (this->half - 1 - prev[j*this->sbox_in + t]);
+                }
+            }
+        }
+    }
+
+    // Round output mask of every S-Box output mask, and the way back
+    const std::vector<int> &post = post_sbox.get_placement_table();
+    this->beta_words.assign(this->num_sboxes, std::vector<uint64_t>(1 << this->sbox_out, 0));
+    for (int j = 0; j < this->num_sboxes; j++)
+    {
+        for (int b = 0; b < (1 << this->sbox_out); b++)
+        {
+            for (int p = 0; p < this->half; p++)
+            {
+                int q = post[p];
+                if (q / this->sbox_out == j && ((b >> (this->sbox_out - 1 - q % this->sbox_out)) & 1))
+                {
+                    this->beta_words[j][b] |= 1ULL << (this->half - 1 - p);
+                }
+            }
+        }
+    }
+    int num_bytes = (this->half + 7) / 8;
+    this->split_words.assign(num_bytes, std::vector<uint64_t>(256, 0));
+    for (int p = 0; p < this->half; p++)
+    {
+        // Word bit half-1-p sits in byte (half-1-p)/8
+        int bit = this->half - 1 - p;
+        uint64_t target = 1ULL << (layer_out - 1 - post[p]);
+        for (int v = 0; v < 256; v++)
+        {
+            if ((v >> (bit % 8)) & 1) this->split_words[bit / 8][v] ^= target;
+        }
+    }
+
+    // Per S-Box candidate lists
+    this->best_out.resize(this->num_sboxes);
+    this->out_order.resize(this->num_sboxes);
+    this->pairs.resize(this->num_sboxes);
+    for (int j = 0; j < this->num_sboxes; j++)
+    {
+        // Best input mask of every output mask
+        this->best_out[j].resize(1 << this->sbox_out);
+        for (int b = 1; b < (1 << this->sbox_out); b++)
+        {
+            this->best_out[j][b] = this->sboxes[j].get_lat_top_out(b);
+            if (this->best_out[j][b].bias != 0) this->out_order[j].push_back(b);
+        }
+        std::stable_sort(this->out_order[j].begin(), this->out_order[j].end(),
+                         [&](int x, int y) { return gt_lat(this->best_out[j][x], this->best_out[j][y]); });
+
+        // All non-trivial approximations
+        for (const lat_entry &entry : this->sboxes[j].get_lat())
+        {
+            if (entry.b != 0 && entry.bias != 0) this->pairs[j].push_back(entry);
+        }
+    }
+}
+
+trail_search::~trail_search()
+{
+    // Destructor Logic
+}
+
+// Bound on the remaining rounds of a non-trivial trail
+double trail_search::rem_bound(int remaining) const
+{
+    // A single remaining round may be inactive
+    return (remaining <= 1) ? 1.0 : this->bounds[remaining];
+}
+
+// S-Box layer output mask of a round output mask
+uint64_t trail_search::split(uint64_t mask) const
+{
+    uint64_t result = 0;
+    for (size_t k = 0; k < this->split_words.size(); k++)
+    {
+        result ^= this->split_words[k][(mask >> (8*k)) & 0xFF];
+    }
+    return result;
+}
+
+// Free round (output masks chosen, best input mask per S-Box)
+void trail_search::search_free(int round, int sbox, double partial)
+{
+    // Round complete
+    if (sbox == this->num_sboxes)
+    {
+        // Skip the trivial trail
+        if (round == this->rounds - 1 && this->beta[0] == 0 && (round == 0 || this->beta[1] == 0)) return;
+        this->close_round(round, partial);
+        return;
+    }
+
+    // Hand the rest of the round to a worker
+    if (round*this->num_sboxes + sbox == this->cut)
+    {
+        this->split_task(round, sbox, partial);
+        return;
+    }
+
+    // Inactive S-Box
+    this->search_free(round, sbox + 1, partial);
+
+    // Active S-Box (candidates by decreasing |bias|)
+    double bound = this->prefix[round] * this->rem_bound(this->rounds - 1 - round);
+    lat_entry *slot = &this->choice[round*this->num_sboxes + sbox];
+    for (int b : this->out_order[sbox])
+    {
+        const lat_entry &entry = this->best_out[sbox][b];
+        double c = partial * entry.bias * this->scale;
+        if (std::fabs(c) * bound <= this->limit()) break;
+
+        this->alpha[round] ^= this->alpha_words[sbox][entry.a];
+        this->beta[round] ^= this->beta_words[sbox][b];
+        *slot = entry;
+        this->search_free(round, sbox + 1, c);
+        this->alpha[round] ^= this->alpha_words[sbox][entry.a];
+        this->beta[round] ^= this->beta_words[sbox][b];
+    }
+    *slot = lat_entry();
+}
+
+// Second round (input and output masks chosen)
+void trail_search::search_pair(int round, int sbox, double partial)
+{
+    // Round complete
+    if (sbox == this->num_sboxes)
+    {
+        // Skip the trivial trail
+        if (this->beta[0] == 0 && this->beta[1] == 0) return;
+        this->close_round(round, partial);
+        return;
+    }
+
+    // Hand the rest of the round to a worker
+    if (round*this->num_sboxes + sbox == this->cut)
+    {
+        this->split_task(round, sbox, partial);
+        return;
+    }
+
+    // Inactive S-Box
+    this->search_pair(round, sbox + 1, partial);
+
+    // Active S-Box (candidates by decreasing |bias|)
+    double bound = this->prefix[round] * this->rem_bound(this->rounds - 1 - round);
+    lat_entry *slot = &this->choice[round*this->num_sboxes + sbox];
+    for (const lat_entry &entry : this->pairs[sbox])
+    {
+        double c = partial * entry.bias * this->scale;
+        if (std::fabs(c) * bound <= this->limit()) break;
+
+        this->alpha[round] ^= this->alpha_words[sbox][entry.a];
+        this->beta[round] ^= this->beta_words[sbox][entry.b];
+        *slot = entry;
+        this->search_pair(round, sbox + 1, c);
+        this->alpha[round] ^= this->alpha_words[sbox][entry.a];
+        this->beta[round] ^= this->beta_words[sbox][entry.b];
+    }
+    *slot = lat_entry();
+}
+
+// Later rounds (output masks fixed by the trail)
+void trail_search::search_fixed(int round, int index, double partial)
+{
+    // Round complete
+    if (index == this->num_active[round])
+    {
+        this->close_round(round, partial);
+        return;
+    }
+
+    // Candidates of the next active S-Box (by decreasing |bias|)
+    int base = round*this->num_sboxes;
+    int sbox = this->active[base + index];
+    lat_entry *slot = &this->choice[base + sbox];
+    double bound = this->prefix[round] * this->rest[round*(this->num_sboxes + 1) + index + 1]
+                   * this->rem_bound(this->rounds - 1 - round);
+    for (const lat_entry &entry : this->sboxes[sbox].get_lat_out(slot->b))
+    {
+        double c = partial * entry.bias * this->scale;
+        if (std::fabs(c) * bound <= this->limit()) break;
+
+        this->alpha[round] ^= this->alpha_words[sbox][entry.a];
+        slot->a = entry.a;
+        slot->bias = entry.bias;
+        this->search_fixed(round, index + 1, c);
+        this->alpha[round] ^= this->alpha_words[sbox][entry.a];
+    }
+}
+
+// Set up a round whose output mask is fixed by the trail
+void trail_search::enter_round(int round)
+{
+    // Output mask and the active S-Boxes
+    this->beta[round] = this->beta[round - 2] ^ this->alpha[round - 1];
+    this->alpha[round] = 0;
+    uint64_t layer = this->split(this->beta[round]);
+    int base = round*this->num_sboxes;
+    int stride = this->num_sboxes + 1;
+    int count = 0;
+    for (int j = 0; j < this->num_sboxes; j++)
+    {
+        int b = (layer >> ((this->num_sboxes - 1 - j) * this->sbox_out)) & ((1 << this->sbox_out) - 1);
+        if (b == 0) continue;
+        this->choice[base + j].b = b;
+        this->active[base + count++] = j;
+    }
+    this->num_active[round] = count;
+
+    // Best possible rest of the round
+    double *rest = &this->rest[round*stride];
+    rest[count] = 1.0;
+    for (int k = count - 1; k >= 0; k--)
+    {
+        int j = this->active[base + k];
+        rest[k] = rest[k + 1] * std::fabs(this->best_out[j][this->choice[base + j].b].bias * this->scale);
+    }
+
+    // Prune, or search (the last round takes the best input masks)
+    if (this->prefix[round] * rest[0] * this->rem_bound(this->rounds - 1 - round) > this->limit())
+    {
+        if (round == this->rounds - 1)
+        {
+            double c = 1.0;
+            for (int k = 0; k < count; k++)
+            {
+                int j = this->active[base + k];
+                const lat_entry &entry = this->best_out[j][this->choice[base + j].b];
+                this->choice[base + j] = entry;
+                this->alpha[round] ^= this->alpha_words[j][entry.a];
+                c *= entry.bias * this->scale;
+            }
+            this->close_round(round, c);
+        }
+        else this->search_fixed(round, 0, 1.0);
+    }
+
+    // Undo
+    for (int k = 0; k < count; k++) this->choice[base + this->active[base + k]] = lat_entry();
+}
+
+// Finish a round and move on to the next one
+void trail_search::close_round(int round, double c)
+{
+    this->corr[round] = c;
+    this->prefix[round + 1] = this->prefix[round] * std::fabs(c);
+
+    int next = round + 1;
+    if (next == this->rounds) this->leaf();
+    else if (next == 1 && this->rounds == 2) this->search_free(next, 0, 1.0);
+    else if (next == 1) this->search_pair(next, 0, 1.0);
+    else this->enter_round(next);
+}
+
+// Full trail
+void trail_search::leaf()
+{
+    // Cheap check before taking the lock
+    double value = this->prefix[this->rounds];
+    if (value <= this->limit()) return;
+
+    // Keep the best top_k trails
+    trail_pool &pool = *this->pool;
+    std::lock_guard<std::mutex> guard(pool.lock);
+    if (value <= pool.limit.load()) return;
+    auto pos = std::upper_bound(pool.found.begin(), pool.found.end(), value,
+                                [](double v, const trail_record &r) { return v > r.value; });
+    pool.found.insert(pos, trail_record{value, this->alpha, this->beta, this->corr, this->choice});
+    if (pool.found.size() > pool.top_k) pool.found.pop_back();
+    if (pool.found.size() == pool.top_k) pool.limit.store(pool.found.back().value);
+}
+
+// Record the state of rounds 1 and 2 as a task
+void trail_search::split_task(int round, int sbox, double partial)
+{
+    int span = std::min(this->rounds, 2);
+    trail_task task;
+    task.round = round;
+    task.sbox = sbox;
+    task.partial = partial;
+    task.corr = this->corr[0];
+    task.alpha.assign(this->alpha.begin(), this->alpha.begin() + span);
+    task.beta.assign(this->beta.begin(), this->beta.begin() + span);
+    task.choice.assign(this->choice.begin(), this->choice.begin() + span*this->num_sboxes);
+    this->tasks->push_back(task);
+}
+
+// Search the subtree of a task
+void trail_search::resume(const trail_task &task)
+{
+    // Restore rounds 1 and 2 (later rounds are set up on the way)
+    std::copy(task.alpha.begin(), task.alpha.end(), this->alpha.begin());
+    std::copy(task.beta.begin(), task.beta.end(), this->beta.begin());
+    std::copy(task.choice.begin(), task.choice.end(), this->choice.begin());
+    this->corr[0] = task.corr;
+    this->prefix[1] = std::fabs(task.corr);
+
+    // Search
+    if (task.round == 0 || this->rounds == 2) this->search_free(task.round, task.sbox, task.partial);
+    else this->search_pair(task.round, task.sbox, task.partial);
+}
+
+// Reset the search state
+void trail_search::reset(int rounds)
+{
+    this->rounds = rounds;
+    this->alpha.assign(rounds, 0);
+    this->beta.assign(rounds, 0);
+    this->corr.assign(rounds, 0.0);
+    this->prefix.assign(rounds + 1, 1.0);
+    this->choice.assign(rounds * this->num_sboxes, lat_entry());
+    this->active.assign(rounds * this->num_sboxes, 0);
+    this->num_active.assign(rounds, 0);
+    this->rest.assign(rounds * (this->num_sboxes + 1), 1.0);
+}
+
+// Search the best top_k trails above the floor, returns how many were found
+size_t trail_search::run(int rounds, double floor, int top_k, const work_pool &workers)
+{
+    // Reset the state
+    trail_pool pool;
+    pool.top_k = top_k;
+    pool.limit.store(floor);
+    this->pool = &pool;
+    this->reset(rounds);
+
+    // Single worker: plain depth-first search
+    int threads = workers.get_num_threads();
+    int levels = this->num_sboxes * std::min(rounds, 2);
+    if (threads == 1 || levels < 2) this->search_free(0, 0, 1.0);
+    else
+    {
+        // Cut rounds 1 and 2 until there are enough tasks to balance
+        std::vector<trail_task> tasks;
+        this->tasks = &tasks;
+        for (int depth = 1; depth < levels; depth++)
+        {
+            tasks.clear();
+            this->cut = depth;
+            this->search_free(0, 0, 1.0);
+            if (tasks.size() >= 32 * (size_t)threads) break;
+        }
+        this->cut = -1;
+        this->tasks = nullptr;
+
+        // Search the tasks on copies of the state
+        std::vector<trail_search> copies(threads, *this);
+        workers.run(tasks.size(), [&](int worker, size_t index) { copies[worker].resume(tasks[index]); });
+    }
+
+    // Keep the trails
+    this->pool = nullptr;
+    this->found = std::move(pool.found);
+    return this->found.size();
+}
+
+// Search with a shrinking floor (starting from the estimate B_{m-1} * B_1)
+void trail_search::run_estimated(int rounds, int top_k, const work_pool &workers)
+{
+    double floor = (rounds > 1) ? this->bounds[rounds - 1] * this->bounds[1] : 0.0;
+    while (this->run(rounds, floor, top_k, workers) < (size_t)top_k && floor > 0)
+    {
+        floor = (floor > 1e-30) ? floor / 2 : 0.0;
+    }
+}
+
+// Trail of a search result
+trail_state trail_search::build_state(int rounds, const trail_record &record) const
+{
+    trail_state state;
+    state.total_rounds = rounds;
+    state.total_sboxes = this->num_sboxes;
+    double total = 0.5;
+    for (int i = 0; i < rounds; i++)
+    {
+        bitstring input_mask(this->half);
+        bitstring output_mask(this->half);
+        bitstring key_mask(this->sbox_in * this->num_sboxes);
+        input_mask.set_uint64(record.alpha[i]);
+        output_mask.set_uint64(record.beta[i]);
+        for (int j = 0; j < this->num_sboxes; j++)
+        {
+            const lat_entry &entry = record.choice[i*this->num_sboxes + j];
+            if (entry.a) key_mask.set_slice(j*this->sbox_in, (j + 1)*this->sbox_in, entry.a);
+            state.alphas.push_back(entry.a);
+            state.betas.push_back(entry.b);
+            state.s_box_biases.push_back(entry.bias / (1 << this->sbox_in));
+        }
+        state.input_masks.push_back(input_mask);
+        state.output_masks.push_back(output_mask);
+        state.key_masks.push_back(key_mask);
+        state.round_biases.push_back(record.corr[i] / 2);
+        total *= record.corr[i];
+    }
+    state.bias = total;
+
+    return state;
+}
+
+// Best top_k trails over the given number of rounds
+std::vector<trail_state> trail_search::search_top(int rounds, int top_k, int threads)
+{
+    // Check if the parameters are valid
+    assert(rounds > 0 && top_k > 0);
+    work_pool workers(threads);
+
+    // Bounds from shorter trails first
+    for (int m = this->bounds.size(); m < rounds; m++)
+    {
+        this->run_estimated(m, 1, workers);
+        this->bounds.push_back(this->found.empty() ? 0.0 : this->found[0].value);
+    }
+    this->run_estimated(rounds, top_k, workers);
+    if ((int)this->bounds.size() == rounds) this->bounds.push_back(this->found.empty() ? 0.0 : this->found[0].value);
+
+    // Build the trails
+    std::vector<trail_state> states;
+    for (const trail_record &record : this->found) states.push_back(this->build_state(rounds, record));
+    return states;
+}
+
+// Best trail over the given number of rounds
+trail_state trail_search::search(int rounds)
+{
+    std::vector<trail_state> states = this->search_top(rounds, 1, 1);
+    if (!states.empty()) return states[0];
+
+    // No trail with a non-zero bias
+    trail_state state;
+    state.total_rounds = rounds;
+    state.total_sboxes = this->num_sboxes;
+    return state;
+}
@@ -0,0 +1,183 @@
+// Class to search linear trails of Feistel networks
+
+/*
+ * Matsui's branch-and-bound search:
+ * Masks are tracked on the round function, i.e. round i uses the
+ * approximation alpha_i . X = beta_i . F(X, K), and consecutive
+ * rounds of a Feistel network are chained by
+ *     beta_{i+1} = beta_{i-1} ^ alpha_i
+ * so beta_1 and beta_2 determine the whole trail once the input
+ * masks of the S-Boxes are chosen. Rounds 1 and 2 are enumerated
+ * freely, later rounds only choose S-Box input masks for the output
+ * masks forced by the trail. The best n-round correlation is bounded
+ * by the best correlations B_m of shorter trails, which are computed
+ * first and used to prune every partial trail that cannot beat the
+ * best trail found so far. As in Matsui's paper, the search starts
+ * from an estimate (B_{n-1} * B_1) of the result and lowers it until
+ * a trail above it is found, so pruning is tight from the start.
+ */
+
+/*
+ * Masks:
+ * Round masks are kept as packed words (bit i of a mask of size n is
+ * bit n - 1 - i of the word), so half blocks and S-Box layers are
+ * limited to 64 bits. State is updated in place and undone on the
+ * way back, nothing is copied per node.
+ */
+
+/*
+ * Parallel search:
+ * The S-Box choices of rounds 1 and 2 are cut at a fixed depth and
+ * every surviving prefix becomes a task of a work-stealing pool.
+ * Workers search on their own copy of the state and share one pool
+ * of results, whose pruning limit (the k-th best |correlation| so
+ * far, or the floor) is an atomic read by every node, so each
+ * worker prunes with the global best. The first round takes the
+ * best input mask of every S-Box and the last round the best input
+ * mask of every active S-Box, so the top k trails differ in their
+ * inner masks. Trails of equal bias may come in any order.
+ */
+
+#ifndef TRAIL_SEARCH_H
+#define TRAIL_SEARCH_H
+
+// Standard Library Imports
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+
+// Custom Library Imports
+#include "s_box.h"
+#include "placement.h"
+#include "bitstring.h"
+#include "work_pool.h"
+
+// Struct to hold a linear trail
+struct trail_state
+{
+  // Net Info
+  int total_rounds = 0;
+  int total_sboxes = 0;
+  float bias = 0.0;                       // Bias of the trail (piling-up lemma)
+
+  // Roundwise Info
+  std::vector<bitstring> input_masks;     // Round function input masks (alpha)
+  std::vector<bitstring> output_masks;    // Round function output masks (beta)
+  std::vector<bitstring> key_masks;       // Round key masks (S-Box layer input)
+  std::vector<float> round_biases;        // Round biases
+
+  // S-Box Info (round-major, total_rounds x total_sboxes)
+  std::vector<int> alphas;                // S-Box input masks
+  std::vector<int> betas;                 // S-Box output masks
+  std::vector<float> s_box_biases;        // S-Box biases
+};
+
+// Print a trail
+void print_state(const trail_state &state);
+
+class trail_search
+{
+  private:
+    // Cipher description
+    int half;                                       // Half block size
+    int num_sboxes;                                 // Number of S-Boxes
+    int sbox_in;                                    // Input size of S-Boxes
+    int sbox_out;                                   // Output size of S-Boxes
+    double scale;                                   // LAT count to correlation
+    std::vector<s_box> sboxes;                      // S-Boxes
+
+    // Mask tables
+    std::vector<std::vector<uint64_t>> alpha_words; // Round input mask of an S-Box input mask [sbox][a]
+    std::vector<std::vector<uint64_t>> beta_words;  // Round output mask of an S-Box output mask [sbox][b]
+    std::vector<std::vector<uint64_t>> split_words; // S-Box layer output mask of a round output byte [byte][value]
+    std::vector<std::vector<lat_entry>> best_out;   // Best entry per output mask [sbox][b]
+    std::vector<std::vector<int>> out_order;        // Non-zero output masks by best |bias| [sbox]
+    std::vector<std::vector<lat_entry>> pairs;      // Non-trivial entries by |bias| [sbox]
+
+    // Bounds (best m-round correlation, bounds[0] = 1)
+    std::vector<double> bounds;
+
+    // A full trail
+    struct trail_record
+    {
+      double value;                                 // |correlation|
+      std::vector<uint64_t> alpha;
+      std::vector<uint64_t> beta;
+      std::vector<double> corr;
+      std::vector<lat_entry> choice;
+    };
+
+    // Prefix of rounds 1 and 2 left to a worker
+    struct trail_task
+    {
+      int round;                                    // Round and S-Box to resume at
+      int sbox;
+      double partial;                               // Correlation of the round so far
+      double corr;                                  // Correlation of round 1
+      std::vector<uint64_t> alpha;
+      std::vector<uint64_t> beta;
+      std::vector<lat_entry> choice;
+    };
+
+    // Best trails of a search (shared by all workers)
+    struct trail_pool
+    {
+      size_t top_k;                                 // Number of trails kept
+      std::atomic<double> limit;                    // Prune at or below this |correlation|
+      std::mutex lock;                              // Guards found
+      std::vector<trail_record> found;              // Best trails by decreasing |correlation|
+    };
+
+    // Search state
+    int rounds;                                     // Rounds of the current search
+    trail_pool *pool;                               // Results of the current search
+    int cut;                                        // S-Box depth of the tasks (-1 = none)
+    std::vector<trail_task> *tasks;                 // Tasks cut so far
+    std::vector<uint64_t> alpha;                    // Round input masks
+    std::vector<uint64_t> beta;                     // Round output masks
+    std::vector<double> corr;                       // Round correlations
+    std::vector<double> prefix;                     // |correlation| of rounds before i
+    std::vector<lat_entry> choice;                  // S-Box approximations [round x sbox]
+    std::vector<int> active;                        // Active S-Boxes [round x sbox]
+    std::vector<int> num_active;                    // Active S-Box count [round]
+    std::vector<double> rest;                       // Best rest of a round [round x (sbox + 1)]
+
+    // Best trails of the last search
+    std::vector<trail_record> found;
+
+    // Search steps
+    double limit() const { return this->pool->limit.load(std::memory_order_relaxed); }
+    double rem_bound(int remaining) const;
+    uint64_t split(uint64_t mask) const;
+    void search_free(int round, int sbox, double partial);
+    void search_pair(int round, int sbox, double partial);
+    void search_fixed(int round, int index, double partial);
+    void enter_round(int round);
+    void close_round(int round, double c);
+    void leaf();
+    void split_task(int round, int sbox, double partial);
+    void resume(const trail_task &task);
+    void reset(int rounds);
+    size_t run(int rounds, double floor, int top_k, const work_pool &workers);
+    void run_estimated(int rounds, int top_k, const work_pool &workers);
+    trail_state build_state(int rounds, const trail_record &record) const;
+
+  public:
+    // Constructors & Destructors
+    trail_search(int block_size, std::vector<s_box> sboxes,
+                 placement prev_sbox, placement post_sbox);
+    ~trail_search();
+
+    // Accessors
+    const std::vector<double> &get_bounds() const { return this->bounds; }
+
+    // Best trail over the given number of rounds
+    trail_state search(int rounds);
+
+    // Best top_k trails over the given number of rounds (0 threads = all cores)
+    std::vector<trail_state> search_top(int rounds, int top_k, int threads);
+};
+
+#endif
@@ -0,0 +1,55 @@
+// Fast Walsh-Hadamard transform
+
+/*
+ * For f of length 2^k, the transform computes
+ *   F[u] = sum_x f[x] * (-1)^(u.x)
+ * in place with k butterfly passes (O(k * 2^k)). Applying it
+ * twice multiplies by 2^k. Used for LATs, correlation spectra and
+ * key ranking by xor-convolution. fwht_bits transforms only the
+ * index bits lo .. hi - 1, i.e. every fibre of the other bits on
+ * its own; over all bits it is the full transform.
+ */
+
+#ifndef WALSH_H
+#define WALSH_H
+
+// Standard Library Imports
+#include <cstddef>
+#include <cassert>
+
+// In-place (unnormalised) Walsh-Hadamard transform over index bits lo .. hi - 1
+template <typename T>
+void fwht_bits(T *data, size_t n, int lo, int hi)
+{
+    // Check if the length is a power of two and the bits are in range
+    assert(n > 0 && (n & (n - 1)) == 0);
+    assert(lo >= 0 && lo <= hi && ((size_t)1 << hi) <= n);
+
+    for (size_t len = (size_t)1 << lo; len < ((size_t)1 << hi); len <<= 1)
+    {
+        for (size_t i = 0; i < n; i += (len << 1))
+        {
+            for (size_t j = i; j < i + len; j++)
+            {
+                T u = data[j];
+                T v = data[j + len];
+                data[j] = u + v;
+                data[j + len] = u - v;
+            }
+        }
+    }
+}
+
+// In-place (unnormalised) Walsh-Hadamard transform
+template <typename T>
+void fwht(T *data, size_t n)
+{
+    // Check if the length is a power of two
+    assert(n > 0 && (n & (n - 1)) == 0);
+
+    int bits = 0;
+    while (((size_t)1 << bits) < n) bits++;
+    fwht_bits(data, n, 0, bits);
+}
+
+#endif
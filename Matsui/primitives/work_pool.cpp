@@ -0,0 +1,70 @@
+// Implementation of the work-stealing thread pool
+#include "work_pool.h"
+
+// Include Libraries
+#include <vector>
+#include <thread>
+#include <cassert>
+
+// Constructors and Destructors
+work_pool::work_pool(int num_threads)
+{
+    // Default to the hardware concurrency
+    if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+    this->num_threads = (num_threads > 0) ? num_threads : 1;
+}
+
+work_pool::~work_pool()
+{
+    // Destructor Logic
+}
+
+// Next task of a worker (own queue first, then steal)
+bool work_pool::take(std::vector<work_queue> &queues, int worker, size_t &task) const
+{
+    // Own queue (front)
+    {
+        std::lock_guard<std::mutex> guard(queues[worker].lock);
+        if (queues[worker].front < queues[worker].back)
+        {
+            task = worker + queues[worker].front++ * this->num_threads;
+            return true;
+        }
+    }
+
+    // Other queues (back)
+    for (int k = 1; k < this->num_threads; k++)
+    {
+        int owner = (worker + k) % this->num_threads;
+        work_queue &victim = queues[owner];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.front < victim.back)
+        {
+            task = owner + --victim.back * this->num_threads;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run task(worker, index) for every index below count
+void work_pool::run(size_t count, const std::function<void(int, size_t)> &task) const
+{
+    // Deal the tasks (round-robin: worker w gets the indices w mod n)
+    std::vector<work_queue> queues(this->num_threads);
+    for (int w = 0; w < this->num_threads; w++)
+    {
+        queues[w].back = (count > (size_t)w) ? (count - w - 1) / this->num_threads + 1 : 0;
+    }
+
+    // Workers
+    auto work = [&](int worker)
+    {
+        size_t index;
+        while (this->take(queues, worker, index)) task(worker, index);
+    };
+    std::vector<std::thread> threads;
+    for (int w = 1; w < this->num_threads && (size_t)w < count; w++) threads.emplace_back(work, w);
+    work(0);
+    for (std::thread &thread : threads) thread.join();
+}
@@ -0,0 +1,53 @@
+// Class to run independent tasks on a work-stealing thread pool
+
+/*
+ * Scheduling:
+ * Tasks are the indices 0 .. count - 1. They are dealt round-robin
+ * to one queue per worker, so every worker starts on the front of
+ * the task list (callers put their most promising tasks first).
+ * A worker takes tasks from the front of its own queue and, once
+ * that runs dry, steals from the back of the other queues. No task
+ * is added while the pool runs, so a worker that finds every queue
+ * empty is done. Worker 0 is the calling thread. A queue only holds
+ * the bounds of its part of the deal (worker w owns w, w + n, w + 2n,
+ * ... for n workers), so the tasks are never materialised and count
+ * may be as large as size_t allows.
+ */
+
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+// Standard Library Imports
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstddef>
+
+class work_pool
+{
+  private:
+    int num_threads;                            // Number of workers
+
+    // Queue of one worker (positions front .. back - 1 of its deal)
+    struct work_queue
+    {
+      std::mutex lock;
+      size_t front = 0;
+      size_t back = 0;
+    };
+
+    bool take(std::vector<work_queue> &queues, int worker, size_t &task) const;
+
+  public:
+    // Constructors & Destructors (0 threads = hardware concurrency)
+    work_pool(int num_threads);
+    ~work_pool();
+
+    // Accessors
+    int get_num_threads() const { return this->num_threads; }
+
+    // Run task(worker, index) for every index below count
+    void run(size_t count, const std::function<void(int, size_t)> &task) const;
+};
+
+#endif